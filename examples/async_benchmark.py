@@ -0,0 +1,71 @@
+import asyncio
+import time
+
+import viet_intent
+
+SENTENCES = [
+    "xin chào",
+    "tôi muốn đặt 2 phở bò",
+    "giá bánh mì bao nhiêu",
+    "cho tôi 50k cà phê sữa",
+    "mấy giờ rồi",
+    "đặt bàn lúc 7 giờ tối",
+    "cảm ơn nhiều",
+    "tạm biệt",
+    "đặt phòng khách sạn",
+    "tôi cần thuê xe"
+]
+
+
+async def measure(name, total, run):
+    """Chạy run() và đo độ trễ lớn nhất của event loop trong lúc chạy"""
+    lag = 0.0
+    done = False
+
+    async def ticker():
+        nonlocal lag
+        while not done:
+            before = time.perf_counter()
+            await asyncio.sleep(0.001)
+            lag = max(lag, time.perf_counter() - before - 0.001)
+
+    tick = asyncio.create_task(ticker())
+    start_time = time.perf_counter()
+    results = await run()
+    total_time = time.perf_counter() - start_time
+    done = True
+    await tick
+
+    intents = sum(1 for r in results if r.intent != "unknown")
+    print(f"  {name:<16} {total_time * 1000:9.1f} ms  {total / total_time:10.0f} q/s"
+          f"  max loop lag {lag * 1000:7.2f} ms  ({intents} recognized)")
+
+
+async def benchmark(concurrency=5000):
+    # "no-entities" không in debug, để đo đúng chi phí nhận dạng
+    engine = viet_intent.IntentEngine("no-entities")
+    texts = (SENTENCES * (concurrency // len(SENTENCES) + 1))[:concurrency]
+    loop = asyncio.get_running_loop()
+
+    # Khởi động: biên dịch model, tạo thread pool
+    await engine.detect_async(texts[0])
+
+    print(f"🚀 {concurrency} concurrent coroutines")
+
+    async def blocking():
+        return [engine.detect(text) for text in texts]
+
+    async def executor():
+        return await asyncio.gather(
+            *(loop.run_in_executor(None, engine.detect, text) for text in texts))
+
+    async def native():
+        return await asyncio.gather(*(engine.detect_async(text) for text in texts))
+
+    await measure("blocking detect", len(texts), blocking)
+    await measure("run_in_executor", len(texts), executor)
+    await measure("detect_async", len(texts), native)
+
+
+if __name__ == "__main__":
+    asyncio.run(benchmark())
@@ -48,5 +48,65 @@ def benchmark():
         percentage = count / len(results) * 100
         print(f"  {intent}: {count} ({percentage:.1f}%)")
 
+def benchmark_pipelines(rounds=20):
+    """So sánh các biến thể pipeline trên cùng tập câu (detect_batch, không in debug)"""
+    test_sentences = [
+        "xin chào",
+        "tôi muốn đặt 2 phở bò",
+        "giá bánh mì bao nhiêu",
+        "cho tôi 50k cà phê sữa",
+        "mấy giờ rồi",
+        "đặt bàn lúc 7 giờ tối",
+        "cảm ơn nhiều",
+        "tạm biệt",
+        "đặt phòng khách sạn",
+        "tôi cần thuê xe"
+    ] * 100
+
+    print("\n🚀 Pipeline variants (detect_batch)...")
+    baseline = None
+    for name in ("full", "no-entities", "fast"):
+        engine = viet_intent.IntentEngine(name)
+        engine.detect_batch(test_sentences)  # biên dịch model
+
+        start_time = time.perf_counter()
+        for _ in range(rounds):
+            batch = engine.detect_batch(test_sentences)
+        total_time = time.perf_counter() - start_time
+
+        queries = len(test_sentences) * rounds
+        qps = queries / total_time
+        baseline = baseline or qps
+        names = batch["intent_names"]
+        unknown = sum(1 for i in batch["intent_ids"] if names[i] == "unknown")
+        print(f"  {name:<12} {total_time / queries * 1e6:8.2f} µs/query"
+              f"  {qps:10.0f} q/s  x{qps / baseline:.2f}"
+              f"  entities={len(batch['entity_keys'])} unknown={unknown}")
+
+
+def benchmark_bulk_build(intents=5000, patterns_per_intent=40):
+    """Dựng model lớn bằng add_intents, in thời gian từng bước theo số thread"""
+    words = ["đặt", "phòng", "khách", "sạn", "thuê", "xe", "máy", "vé", "tàu",
+             "bay", "hủy", "đơn", "giao", "hàng", "đổi", "trả", "thẻ"]
+    specs = []
+    for i in range(intents):
+        patterns = [f"{words[(i + j) % len(words)]} {words[(i * 3 + j) % len(words)]} mã {i} số {j}"
+                    for j in range(patterns_per_intent)]
+        specs.append(viet_intent.IntentSpec(f"intent_{i}", patterns, response=f"#{i}"))
+
+    print(f"\n🚀 Bulk build ({intents} intents x {patterns_per_intent} patterns)...")
+    fingerprints = set()
+    for threads in (1, 2, 4, 0):
+        engine = viet_intent.IntentEngine("no-entities")
+        stats = engine.add_intents(specs, threads)
+        fingerprints.add(stats.fingerprint)
+        print(f"  threads={stats.threads:<3} store {stats.store_ms:7.1f} ms"
+              f"  prepare {stats.prepare_ms:7.1f} ms  index {stats.index_ms:7.1f} ms"
+              f"  automaton {stats.automaton_ms:7.1f} ms  total {stats.total_ms:7.1f} ms")
+    print(f"  keys={stats.keys} states={stats.states} duplicates={stats.duplicates}"
+          f"  identical models: {len(fingerprints) == 1}")
+
 if __name__ == "__main__":
     benchmark()
+    benchmark_pipelines()
+    benchmark_bulk_build()
@@ -0,0 +1,42 @@
+#ifndef CLAUSE_SEGMENTER_H
+#define CLAUSE_SEGMENTER_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace VietIntent {
+
+struct ClauseToken {
+    size_t begin;        // vị trí byte [begin, end) trong văn bản gốc, không gồm dấu câu
+    size_t end;
+    size_t norm_begin;   // vị trí [norm_begin, norm_end) trong Segmentation::normalized
+    size_t norm_end;
+};
+
+struct Clause {
+    size_t first_token;  // token [first_token, last_token) trong Segmentation::tokens
+    size_t last_token;
+    size_t begin;        // vị trí byte trong văn bản gốc
+    size_t end;
+    size_t norm_begin;   // vị trí trong Segmentation::normalized
+    size_t norm_end;
+};
+
+struct Segmentation {
+    std::string normalized;            // toàn bộ văn bản, giống TextPreprocessor::normalize
+    std::vector<ClauseToken> tokens;
+    std::vector<Clause> clauses;
+};
+
+// Tách câu nhiều ý thành mệnh đề tại dấu câu (, . ; : ! ?) và liên từ
+// "và", "rồi", "với". Văn bản chỉ được chuẩn hóa một lần; liên từ không thuộc
+// mệnh đề nào và chỉ tách khi phía sau còn token ("mấy giờ rồi" giữ nguyên).
+class ClauseSegmenter {
+public:
+    static Segmentation segment(const std::string& text);
+};
+
+}
+
+#endif
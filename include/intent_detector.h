@@ -10,6 +10,20 @@ namespace VietIntent {
 
 // Forward declaration của IntentResult từ viet_intent.h
 struct IntentResult;
+struct BatchResult;
+struct IntentSpan;
+struct PrefilterConfig;
+struct PrefilterStats;
+struct DetectOptions;
+struct DegradationStats;
+struct EvaluationStats;
+struct IntentSpec;
+struct BuildStats;
+struct CaptureConfig;
+struct CaptureStats;
+enum class LoadLevel;
+enum class Pipeline;
+class DetectionSession;
 
 struct IntentPattern {
     std::vector<std::string> patterns;
@@ -20,16 +34,69 @@ struct IntentPattern {
 class IntentDetector {
 public:
     IntentDetector();
+    explicit IntentDetector(Pipeline pipeline);
     ~IntentDetector();
 
+    // Biến thể pipeline cố định từ lúc tạo
+    Pipeline pipeline() const;
+
     IntentResult detect(const std::string& text);
 
+    // Detect với ngân sách thời gian; bỏ dần các bước tốn kém khi hết giờ hoặc quá tải
+    IntentResult detect(const std::string& text, const DetectOptions& options);
+
+    // Nhận dạng hàng loạt, không in debug, kết quả dạng cột
+    BatchResult detect_batch(const std::vector<std::string>& texts);
+
+    // Tách mệnh đề ("chào bạn, cho tôi 2 phở, giá bao nhiêu?") và nhận dạng từng mệnh đề;
+    // bỏ qua mệnh đề "unknown", không in debug
+    std::vector<IntentSpan> detect_multi(const std::string& text);
+
+    // Phiên nhận dạng tăng dần trên model hiện tại
+    std::unique_ptr<DetectionSession> create_session();
+
     void add_intent(const std::string& intent_name,
                    const IntentPattern& pattern,
                    const std::string& response_pattern = "");
 
+    // Nạp nhiều intent rồi biên dịch model ngay: chuẩn hóa, tách token, bỏ trùng
+    // song song theo intent, gộp theo thứ tự cố định nên model giống hệt nhau
+    // với mọi số thread. Spec trùng tên: spec sau ghi đè spec trước.
+    BuildStats add_intents(const std::vector<IntentSpec>& specs, size_t threads = 0);
+    BuildStats build_stats() const;
+
     bool load_from_json(const std::string& filepath);
 
+    // Bộ lọc ngoài miền
+    void set_prefilter(const PrefilterConfig& config);
+    PrefilterConfig prefilter() const;
+    PrefilterStats prefilter_stats() const;
+    void reset_prefilter_stats();
+
+    // Giảm tải
+    void set_load_level(LoadLevel level);
+    LoadLevel load_level() const;
+    DegradationStats degradation_stats() const;
+    void reset_degradation_stats();
+
+    // Lấy mẫu truy vấn ra file (detect và detect_batch)
+    bool start_capture(const CaptureConfig& config);
+    void stop_capture();
+    CaptureStats capture_stats() const;
+
+    // Thứ tự chấm điểm theo tần suất thắng của từng intent (mặc định tắt: thứ tự
+    // cố định). Kết quả không phụ thuộc thứ tự, chỉ số intent phải chấm thay đổi.
+    void set_adaptive_order(bool enabled);
+    bool adaptive_order() const;
+    std::vector<std::string> evaluation_order();
+
+    // File thống kê lượt thắng (tên intent <tab> số lượt) để khởi động với thứ tự đã học
+    bool load_order_stats(const std::string& filepath);
+    bool save_order_stats(const std::string& filepath);
+
+    EvaluationStats evaluation_stats() const;
+    void reset_evaluation_stats();
+
 private:
     class Impl;
     std::unique_ptr<Impl> pimpl;
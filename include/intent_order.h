@@ -0,0 +1,68 @@
+#ifndef INTENT_ORDER_H
+#define INTENT_ORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace VietIntent {
+
+// Thứ tự chấm điểm intent kèm cận trên của phần còn lại để dừng sớm.
+// Chỉ số là vị trí intent trong model (thứ tự gốc, dùng để phân xử khi hòa điểm).
+struct IntentOrder {
+    std::vector<uint32_t> indices;       // chỉ số intent theo thứ tự chấm
+    std::vector<double> suffix_bound;    // cận trên lớn nhất của indices[k..]
+    std::vector<uint32_t> suffix_first;  // chỉ số nhỏ nhất trong indices[k..]
+
+    IntentOrder(std::vector<uint32_t> order, const std::vector<double>& upper_bounds);
+
+    // true nếu không intent nào từ vị trí k trở đi thắng được best: điểm cao hơn,
+    // hoặc bằng điểm nhưng đứng trước best_index (-1 = chưa có intent thắng)
+    bool exhausted(size_t k, double best, int best_index) const {
+        double bound = suffix_bound[k];
+        return bound < best ||
+               (bound == best && (best_index < 0 || suffix_first[k] > static_cast<uint32_t>(best_index)));
+    }
+};
+
+// Đếm lượt thắng của từng intent và sắp lại thứ tự chấm điểm theo tần suất
+// (giảm dần, hòa thì theo chỉ số gốc). Thread nhận dạng chỉ tăng bộ đếm;
+// thứ tự mới được tính mỗi reorder_interval lượt và thay bằng con trỏ nguyên tử.
+class AdaptiveOrder {
+public:
+    AdaptiveOrder(std::vector<double> upper_bounds, uint64_t reorder_interval = 1024);
+
+    AdaptiveOrder(const AdaptiveOrder&) = delete;
+    AdaptiveOrder& operator=(const AdaptiveOrder&) = delete;
+
+    size_t size() const { return bounds.size(); }
+
+    // Thứ tự gốc 0..n-1, không đổi
+    const IntentOrder& canonical() const { return *initial; }
+
+    // Thứ tự hiện tại theo tần suất
+    std::shared_ptr<const IntentOrder> current() const;
+
+    void record(size_t index);
+
+    uint64_t hits(size_t index) const;
+    void set_hits(size_t index, uint64_t count);
+
+    // Sắp lại ngay theo bộ đếm hiện tại
+    void reorder();
+
+private:
+    std::vector<double> bounds;
+    uint64_t interval;
+    std::shared_ptr<const IntentOrder> initial;
+    std::shared_ptr<const IntentOrder> order;    // đọc/ghi qua std::atomic_load/store
+    std::unique_ptr<std::atomic<uint64_t>[]> counts;
+    std::atomic<uint64_t> recorded{0};
+    std::mutex reorder_mutex;
+};
+
+}
+
+#endif
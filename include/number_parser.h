@@ -0,0 +1,36 @@
+#ifndef NUMBER_PARSER_H
+#define NUMBER_PARSER_H
+
+#include <string>
+#include <cstddef>
+
+namespace VietIntent {
+
+enum class NumericType {
+    NUMBER,   // số đếm: "2", "hai mươi lăm", "3 rưỡi"
+    MONEY,    // tiền (đồng): "50k", "2tr5", "hai mươi lăm nghìn", "30.000đ"
+    TIME      // giờ: "7 giờ tối", "7h30", "8 giờ kém 15"
+};
+
+struct NumericEntity {
+    NumericType type;
+    double value;   // NUMBER: giá trị; MONEY: số đồng; TIME: số phút kể từ 0h
+    size_t begin;   // vị trí byte [begin, end) trong chuỗi đã chuẩn hóa
+    size_t end;
+};
+
+// Bộ phân tích trạng thái hữu hạn cho số, tiền và giờ tiếng Việt.
+// Chạy một lượt trên token của chuỗi đã chuẩn hóa (TextPreprocessor::normalize),
+// không cấp phát bộ nhớ.
+class NumberParser {
+public:
+    // Ghi tối đa capacity entity vào out theo thứ tự xuất hiện, trả về số entity đã ghi
+    static size_t parse(const std::string& normalized, NumericEntity* out, size_t capacity);
+
+    // Dạng chuỗi cho IntentResult::entities: "25000", "3.5", "19:30"
+    static std::string format(const NumericEntity& entity);
+};
+
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace VietIntent {
+
+// Automaton Aho-Corasick trên văn bản đã chuẩn hóa.
+// Mọi pattern/keyword được dò trong một lượt duyệt duy nhất, mỗi byte O(1),
+// nên có thể nạp văn bản từng phần (streaming) mà không phải quét lại.
+class PatternMatcher {
+public:
+    PatternMatcher();
+
+    // Thêm khóa (đã chuẩn hóa), trả về id; khóa trùng trả về id cũ
+    int add(const std::string& key);
+
+    // Dựng bảng chuyển trạng thái; gọi sau khi đã add() xong
+    void build();
+
+    static constexpr int ROOT = 0;
+
+    int step(int state, unsigned char c) const {
+        return transitions[static_cast<size_t>(state) * alphabet_size + byte_class[c]];
+    }
+
+    // Gọi fn(key_id) cho mọi khóa kết thúc tại trạng thái này
+    template <typename Fn>
+    void for_each_match(int state, Fn&& fn) const {
+        for (uint32_t i = output_begin[state]; i < output_begin[state + 1]; ++i) {
+            fn(outputs[i]);
+        }
+    }
+
+    size_t key_length(int id) const { return keys[id].length(); }
+    const std::string& key(int id) const { return keys[id]; }
+    size_t key_count() const { return keys.size(); }
+    size_t state_count() const { return output_begin.empty() ? 0 : output_begin.size() - 1; }
+
+private:
+    std::vector<std::string> keys;
+    std::unordered_map<std::string, int> key_ids;
+
+    uint8_t byte_class[256];
+    size_t alphabet_size = 1;
+    std::vector<int> transitions;
+    std::vector<uint32_t> output_begin;
+    std::vector<int> outputs;
+};
+
+}
+
+#endif
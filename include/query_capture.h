@@ -0,0 +1,195 @@
+#ifndef QUERY_CAPTURE_H
+#define QUERY_CAPTURE_H
+
+#include "viet_intent.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace VietIntent {
+
+// Bản ghi kích thước cố định cho một câu được lấy mẫu
+struct CaptureRecord {
+    static constexpr size_t TEXT_SIZE = 256;
+    static constexpr size_t NAME_SIZE = 24;
+    static constexpr size_t MAX_SCORES = 8;
+
+    // Điểm của một intent qua các bước: exact/contains/keyword, độ tương đồng, điểm cuối
+    struct Score {
+        char intent[NAME_SIZE];
+        float match;
+        float similarity;
+        float score;
+    };
+
+    int64_t timestamp_us;
+    uint16_t input_length;
+    uint16_t normalized_length;
+    bool input_truncated;
+    bool degraded;
+    uint8_t score_count;
+    uint32_t stages;
+    float confidence;
+    char intent[NAME_SIZE];
+    char input[TEXT_SIZE];        // UTF-8, cắt tại ranh giới ký tự
+    char normalized[TEXT_SIZE];
+    Score scores[MAX_SCORES];
+
+    void set_input(const std::string& text);
+    void set_normalized(const std::string& text);
+
+    // Chép tên intent (cắt còn NAME_SIZE - 1 byte, luôn kết thúc bằng '\0')
+    static void set_name(char* dst, const std::string& name);
+};
+
+// Điểm từng intent của một câu cho CaptureRecord. Giữ intent thắng và các intent
+// điểm cao nhất còn lại (tối đa MAX_SCORES), không phụ thuộc vị trí trong model.
+class CaptureScores {
+public:
+    // Điểm của intent index (vị trí trong model)
+    void add(int index, const CaptureRecord::Score& score);
+
+    // Intent đang thắng vòng chấm điểm; score là điểm đã add cho intent đó
+    void set_winner(int index, const CaptureRecord::Score& score);
+
+    // Chép vào out theo điểm giảm dần (hòa điểm thì theo vị trí), trả về số điểm đã chép
+    size_t copy_to(CaptureRecord::Score* out) const;
+
+private:
+    CaptureRecord::Score entries[CaptureRecord::MAX_SCORES];
+    int indices[CaptureRecord::MAX_SCORES];
+    size_t count = 0;
+    CaptureRecord::Score winner;
+    int winner_index = -1;
+};
+
+// Hàng đợi vòng nhiều producer / một consumer, không khóa (Vyukov).
+// Producer ghi thẳng vào ô đã giành được; hàng đầy thì trả về false ngay.
+class CaptureRing {
+public:
+    explicit CaptureRing(size_t capacity);  // làm tròn lên lũy thừa của 2
+
+    template <typename Fill>
+    bool try_push(Fill&& fill) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[pos & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        fill(slot->record);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Chỉ gọi từ thread consumer duy nhất
+    template <typename Consume>
+    bool try_consume(Consume&& consume) {
+        Slot& slot = slots[dequeue_pos & mask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeue_pos + 1) < 0) {
+            return false;
+        }
+        consume(static_cast<const CaptureRecord&>(slot.record));
+        slot.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+        ++dequeue_pos;
+        return true;
+    }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<size_t> sequence;
+        CaptureRecord record;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) size_t dequeue_pos = 0;
+};
+
+// Ghi mẫu truy vấn ra file JSONL xoay vòng. Thread nhận dạng chỉ đẩy bản ghi
+// vào CaptureRing; thread writer nền gom theo lô mỗi flush_interval.
+class QueryCapture {
+public:
+    explicit QueryCapture(const CaptureConfig& config);
+    ~QueryCapture();
+
+    QueryCapture(const QueryCapture&) = delete;
+    QueryCapture& operator=(const QueryCapture&) = delete;
+
+    // Mở file và chạy thread writer; false nếu không mở được file
+    bool start();
+
+    // Dừng writer sau khi ghi nốt các bản ghi đang chờ, rồi đóng file
+    void stop();
+
+    // Quyết định lấy mẫu cho câu hiện tại (RNG riêng mỗi thread)
+    bool sample() const;
+
+    // Bản ghi đến sau khi stop() đã bắt đầu (thread nhận dạng còn giữ capture cũ)
+    // được tính là dropped, nên sau stop() luôn có captured == written
+    template <typename Fill>
+    void capture(Fill&& fill) {
+        // Cặp seq_cst với stop(): hoặc stop() thấy producer này và chờ nó đẩy xong
+        // trước lần flush cuối, hoặc producer thấy closed và bỏ bản ghi
+        producers.fetch_add(1, std::memory_order_seq_cst);
+        if (closed.load(std::memory_order_seq_cst)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        } else if (ring.try_push(std::forward<Fill>(fill))) {
+            captured.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        producers.fetch_sub(1, std::memory_order_release);
+    }
+
+    CaptureStats stats() const;
+
+private:
+    void run();
+    void flush();
+    void rotate();
+
+    CaptureConfig config;
+    uint64_t threshold;     // sample() khi số ngẫu nhiên < threshold
+    bool sample_all;
+    CaptureRing ring;
+
+    std::ofstream file;
+    uint64_t file_bytes = 0;
+    std::string buffer;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::atomic<bool> closed{false};
+    std::atomic<int> producers{0};     // số thread đang ở trong capture()
+
+    std::atomic<uint64_t> captured{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> rotations{0};
+};
+
+}
+
+#endif
@@ -10,6 +10,10 @@ class TextPreprocessor {
 public:
     static std::string normalize(const std::string& text);
     static std::vector<std::string> tokenize(const std::string& text);
+
+    // Token dùng làm keyword tự sinh từ pattern: bỏ token ngắn hơn 2 ký tự hoặc
+    // chỉ gồm chữ số (vd. "5", "2024"), vì chúng khớp với quá nhiều câu
+    static std::vector<std::string> keyword_tokens(const std::string& text);
     static std::string remove_diacritics(const std::string& text);
 
     // Chuẩn hóa tiếng Việt
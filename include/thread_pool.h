@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VietIntent {
+
+// Nhóm thread cố định chạy tác vụ theo thứ tự gửi (FIFO). Tác vụ tự xử lý lỗi
+// của mình: ngoại lệ thoát ra khỏi tác vụ bị bỏ qua để worker không chết.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0);   // 0 = số lõi
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // false nếu pool đã dừng
+    bool submit(std::function<void()> task);
+
+    // Chạy nốt các tác vụ đang chờ rồi dừng worker; gọi nhiều lần không sao
+    void shutdown();
+
+    size_t size() const { return workers.size(); }
+
+    // Chia [0, count) thành các đoạn liên tiếp, chạy fn(begin, end) song song rồi chờ
+    // tất cả xong; ngoại lệ đầu tiên được ném lại sau khi mọi đoạn đã dừng.
+    // Không gọi từ trong tác vụ của chính pool này.
+    void parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn);
+
+    // Số tác vụ đang chờ hoặc đang chạy
+    size_t pending() const;
+
+private:
+    void run();
+
+    std::vector<std::thread> workers;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+}
+
+#endif
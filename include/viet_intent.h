@@ -5,28 +5,235 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <cstdint>
+#include <chrono>
 
 namespace VietIntent {
 
+// Các bước nhận dạng, dùng làm bit trong IntentResult::stages
+enum DetectionStage : uint32_t {
+    STAGE_PREFILTER  = 1u << 0,
+    STAGE_EXACT      = 1u << 1,
+    STAGE_CONTAINS   = 1u << 2,
+    STAGE_KEYWORDS   = 1u << 3,
+    STAGE_SIMILARITY = 1u << 4,
+    STAGE_HEURISTICS = 1u << 5,
+    STAGE_ENTITIES   = 1u << 6
+};
+
 struct IntentResult {
     std::string intent;
     double confidence;
     std::map<std::string, std::string> entities;
     std::string response_pattern;
+
+    uint32_t stages = 0;     // các DetectionStage đã chạy
+    bool degraded = false;   // đã bỏ qua bước tốn kém vì hết ngân sách / quá tải
+};
+
+// Một ý trong câu nhiều ý: kết quả của một mệnh đề và vị trí của nó
+struct IntentSpan : IntentResult {
+    size_t begin = 0;   // vị trí byte [begin, end) trong văn bản gốc (UTF-8)
+    size_t end = 0;
+    std::string text;   // văn bản gốc của mệnh đề
+};
+
+// Kết quả hàng loạt dạng cột (không tạo đối tượng cho từng câu).
+// Entities của câu i nằm trong [entity_offsets[i], entity_offsets[i + 1]);
+// giá trị của entity j là value_data[value_offsets[j], value_offsets[j + 1]).
+struct BatchResult {
+    std::vector<int32_t> intent_ids;        // chỉ số trong intent_names
+    std::vector<float> confidences;
+    std::vector<std::string> intent_names;  // intent_names[0] = "unknown"
+
+    std::vector<int64_t> entity_offsets;    // size = số câu + 1
+    std::vector<int32_t> entity_keys;       // chỉ số trong entity_names
+    std::vector<std::string> entity_names;
+    std::vector<int64_t> value_offsets;     // size = số entity + 1
+    std::string value_data;                 // UTF-8 nối liền
+};
+
+// Bộ lọc ngoài miền: câu có quá ít token/bigram nằm trong từ vựng model
+// được trả về "unknown" ngay, không qua bước chấm điểm và heuristic.
+// Mặc định tắt: từ vựng chỉ gồm pattern/keyword và tên món có sẵn, nên câu
+// gọi món ngoài danh sách có thể bị loại nhầm.
+struct PrefilterConfig {
+    bool enabled = false;
+    double min_coverage = 0.3;    // độ phủ tối thiểu (0..1) để được chấm điểm
+    size_t min_tokens = 2;        // chỉ lọc câu có ít nhất ngần này token nội dung
+};
+
+struct PrefilterStats {
+    uint64_t checked = 0;
+    uint64_t rejected = 0;
+};
+
+// Mức tải toàn cục: NORMAL chạy đủ các bước, ELEVATED bỏ trích xuất thực thể,
+// CRITICAL bỏ thêm bước độ tương đồng (chỉ còn exact/contains/keyword và heuristic)
+enum class LoadLevel {
+    NORMAL,
+    ELEVATED,
+    CRITICAL
+};
+
+// Biến thể pipeline, chọn khi tạo IntentEngine. Bước không dùng bị loại lúc biên dịch.
+enum class Pipeline {
+    FULL,         // đủ các bước, in debug trong detect()
+    FAST,         // chỉ exact + keyword, không heuristic, không thực thể
+    NO_ENTITIES   // như FULL nhưng không trích xuất thực thể, không in debug
+};
+
+// Dừng sớm khi chấm điểm: số intent được chấm và bị bỏ qua vì cận trên
+// không thắng được intent tốt nhất hiện tại
+struct EvaluationStats {
+    uint64_t evaluations = 0;
+    uint64_t intents_scored = 0;
+    uint64_t intents_pruned = 0;
+};
+
+struct DetectOptions {
+    // Ngân sách thời gian cho một lần detect, 0 = không giới hạn. Được kiểm tra
+    // giữa các bước; khi hết, các bước tốn kém còn lại bị bỏ qua.
+    std::chrono::microseconds budget{0};
+};
+
+struct DegradationStats {
+    uint64_t requests = 0;            // số lần detect
+    uint64_t degraded = 0;            // số kết quả đã bỏ qua ít nhất một bước
+    uint64_t budget_exceeded = 0;     // trong đó do hết ngân sách thời gian
+    uint64_t similarity_skipped = 0;
+    uint64_t entities_skipped = 0;
+};
+
+// Lấy mẫu truy vấn thật (văn bản, dạng chuẩn hóa, intent, điểm từng bước) ra file JSONL
+struct CaptureConfig {
+    std::string path = "capture.jsonl";
+    double sample_rate = 0.01;                  // tỷ lệ lấy mẫu (0..1)
+    size_t buffer_records = 4096;               // sức chứa ring buffer; đầy thì bỏ bản ghi
+    uint64_t max_file_bytes = 64ull << 20;      // xoay file khi vượt quá
+    size_t max_files = 5;                       // số file cũ giữ lại: path.1 ... path.N
+    std::chrono::milliseconds flush_interval{200};
+};
+
+struct CaptureStats {
+    uint64_t captured = 0;    // đã đưa vào ring buffer
+    uint64_t dropped = 0;     // bỏ vì ring buffer đầy
+    uint64_t written = 0;     // đã ghi ra file
+    uint64_t rotations = 0;
+};
+
+// Một intent cho add_intents. keywords rỗng thì lấy các token của patterns như
+// add_intent (bỏ token ngắn hơn 2 ký tự hoặc chỉ gồm chữ số)
+struct IntentSpec {
+    std::string name;
+    std::vector<std::string> patterns;
+    std::vector<std::string> keywords;
+    double threshold = 0.5;
+    std::string response_pattern;
+};
+
+// Thời gian dựng model theo từng bước (ms) và kích thước model
+struct BuildStats {
+    size_t threads = 1;
+    size_t intents = 0;          // số intent trong model
+    size_t keys = 0;             // số khóa khác nhau trong automaton
+    size_t states = 0;           // số trạng thái automaton
+    size_t duplicates = 0;       // pattern/keyword trùng trong cùng intent đã gộp
+
+    double store_ms = 0;         // tách keyword, ghi vào bảng intent
+    double prepare_ms = 0;       // chuẩn hóa, tách token, bỏ trùng (song song theo intent)
+    double index_ms = 0;         // gộp theo thứ tự intent: id khóa, danh sách hit, từ vựng
+    double automaton_ms = 0;     // dựng bảng chuyển Aho-Corasick
+    double total_ms = 0;
+
+    uint64_t fingerprint = 0;    // băm nội dung model: cùng đầu vào thì cùng giá trị
+};
+
+class IntentDetector;
+
+// Nhận dạng tăng dần cho văn bản đến từng phần (ASR partial, gõ phím).
+// Mỗi lần cập nhật chỉ xử lý phần mới: các token đã hoàn chỉnh được chốt vào
+// trạng thái automaton, token cuối được chấm tạm rồi hoàn tác.
+class DetectionSession {
+public:
+    ~DetectionSession();
+
+    // Nối thêm văn bản, trả về intent tốt nhất hiện tại (chưa có entities)
+    const IntentResult& append(const std::string& chunk);
+
+    // Xóa erase_bytes byte cuối rồi nối replacement (ASR sửa giả thuyết)
+    const IntentResult& revise(size_t erase_bytes, const std::string& replacement);
+
+    void reset();
+
+    const IntentResult& current() const;
+
+    // Kết quả đầy đủ kèm entities, giống IntentEngine::detect
+    IntentResult result() const;
+
+    const std::string& text() const;
+
+private:
+    friend class IntentDetector;
+    class Impl;
+    explicit DetectionSession(std::unique_ptr<Impl> impl);
+    std::unique_ptr<Impl> pimpl;
 };
 
 class IntentEngine {
 public:
     IntentEngine();
+    explicit IntentEngine(Pipeline pipeline);
     ~IntentEngine();
 
+    Pipeline pipeline() const;
+
     bool initialize(const std::string& model_path = "models/");
     IntentResult detect(const std::string& text);
+    IntentResult detect(const std::string& text, const DetectOptions& options);
+
+    BatchResult detect_batch(const std::vector<std::string>& texts);
+
+    // Tách câu thành mệnh đề và nhận dạng từng mệnh đề; mỗi mệnh đề cho một span,
+    // kể cả mệnh đề "unknown"
+    std::vector<IntentSpan> detect_multi(const std::string& text);
+
+    std::unique_ptr<DetectionSession> create_session();
 
     void add_intent(const std::string& intent_name,
                     const std::vector<std::string>& patterns,
                     const std::string& response_pattern = "");
 
+    // Nạp nhiều intent một lần và dựng model ngay, song song trên threads thread
+    // (0 = số lõi). Kết quả không phụ thuộc số thread. Trong lúc dựng, detect()
+    // ở thread khác vẫn chạy trên model cũ.
+    BuildStats add_intents(const std::vector<IntentSpec>& specs, size_t threads = 0);
+
+    // Thống kê lần dựng model gần nhất
+    BuildStats build_stats() const;
+
+    void set_prefilter(const PrefilterConfig& config);
+    PrefilterConfig prefilter() const;
+    PrefilterStats prefilter_stats() const;
+    void reset_prefilter_stats();
+
+    void set_load_level(LoadLevel level);
+    LoadLevel load_level() const;
+    DegradationStats degradation_stats() const;
+    void reset_degradation_stats();
+
+    bool start_capture(const CaptureConfig& config);
+    void stop_capture();
+    CaptureStats capture_stats() const;
+
+    void set_adaptive_order(bool enabled);
+    bool adaptive_order() const;
+    std::vector<std::string> evaluation_order();
+    bool load_order_stats(const std::string& filepath);
+    bool save_order_stats(const std::string& filepath);
+    EvaluationStats evaluation_stats() const;
+    void reset_evaluation_stats();
+
     void load_patterns_from_file(const std::string& filepath);
     void save_patterns(const std::string& filepath);
 
@@ -1,4 +1,14 @@
-from .viet_intent import IntentEngine, IntentResult
+from .viet_intent import IntentEngine, IntentResult, IntentSpan, DetectionSession
+from .viet_intent import PrefilterConfig, PrefilterStats
+from .viet_intent import DetectionStage, LoadLevel, DegradationStats, Pipeline
+from .viet_intent import EvaluationStats
+from .viet_intent import IntentSpec, BuildStats
+from .viet_intent import CaptureConfig, CaptureStats
+from .viet_intent import set_async_threads
 
 __version__ = "0.1.0"
-__all__ = ["IntentEngine", "IntentResult"]
+__all__ = ["IntentEngine", "IntentResult", "IntentSpan", "DetectionSession",
+           "PrefilterConfig", "PrefilterStats",
+           "DetectionStage", "LoadLevel", "DegradationStats", "Pipeline",
+           "EvaluationStats", "IntentSpec", "BuildStats",
+           "CaptureConfig", "CaptureStats", "set_async_threads"]
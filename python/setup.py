@@ -31,6 +31,12 @@ ext_modules = [
         sources=[
             os.path.join(src_dir, 'text_preprocessor.cpp'),
             os.path.join(src_dir, 'intent_detector.cpp'),
+            os.path.join(src_dir, 'number_parser.cpp'),
+            os.path.join(src_dir, 'clause_segmenter.cpp'),
+            os.path.join(src_dir, 'query_capture.cpp'),
+            os.path.join(src_dir, 'intent_order.cpp'),
+            os.path.join(src_dir, 'thread_pool.cpp'),
+            os.path.join(src_dir, 'pattern_matcher.cpp'),
             os.path.join(src_dir, 'viet_intent.cpp'),
             os.path.join(base_dir, 'viet_intent_py.cpp')
         ],
@@ -58,9 +64,9 @@ setup(
     packages=['viet_intent'],
     package_dir={'': 'python'},
     python_requires='>=3.6',
-    install_requires=['pybind11>=2.6.0'],
+    install_requires=['pybind11>=2.6.0', 'numpy>=1.19.0'],
     extras_require={
-        'dev': ['pytest>=6.0', 'numpy>=1.19.0'],
+        'dev': ['pytest>=6.0'],
     },
     classifiers=[
         'Development Status :: 4 - Beta',
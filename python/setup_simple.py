@@ -32,6 +32,12 @@ ext = Extension(
     sources=[
         os.path.join(src_dir, 'text_preprocessor.cpp'),
         os.path.join(src_dir, 'intent_detector.cpp'),
+        os.path.join(src_dir, 'number_parser.cpp'),
+        os.path.join(src_dir, 'clause_segmenter.cpp'),
+        os.path.join(src_dir, 'query_capture.cpp'),
+        os.path.join(src_dir, 'intent_order.cpp'),
+        os.path.join(src_dir, 'thread_pool.cpp'),
+        os.path.join(src_dir, 'pattern_matcher.cpp'),
         os.path.join(src_dir, 'viet_intent.cpp'),
         os.path.join(base_dir, 'viet_intent_py.cpp')
     ],
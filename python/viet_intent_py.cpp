@@ -1,9 +1,273 @@
+#include "thread_pool.h"
 #include "viet_intent.h"
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
 namespace py = pybind11;
 
+namespace {
+
+// Chuyển vector sang NumPy array không sao chép: array giữ vector qua capsule
+template <typename T> py::array_t<T> to_numpy(std::vector<T> &&values) {
+  auto *owner = new std::vector<T>(std::move(values));
+  py::capsule capsule(
+      owner, [](void *p) { delete static_cast<std::vector<T> *>(p); });
+  return py::array_t<T>(owner->size(), owner->data(), capsule);
+}
+
+py::dict detect_batch(VietIntent::IntentEngine &engine, py::handle texts) {
+  auto inputs = texts.cast<std::vector<std::string>>();
+
+  VietIntent::BatchResult batch;
+  {
+    py::gil_scoped_release release;
+    batch = engine.detect_batch(inputs);
+  }
+
+  std::vector<uint8_t> value_data(batch.value_data.begin(),
+                                  batch.value_data.end());
+
+  py::dict result;
+  result["intent_ids"] = to_numpy(std::move(batch.intent_ids));
+  result["confidences"] = to_numpy(std::move(batch.confidences));
+  result["intent_names"] = batch.intent_names;
+  result["entity_offsets"] = to_numpy(std::move(batch.entity_offsets));
+  result["entity_keys"] = to_numpy(std::move(batch.entity_keys));
+  result["entity_names"] = batch.entity_names;
+  result["value_offsets"] = to_numpy(std::move(batch.value_offsets));
+  result["value_data"] = to_numpy(std::move(value_data));
+  return result;
+}
+
+const std::pair<uint32_t, const char *> STAGE_NAMES[] = {
+    {VietIntent::STAGE_PREFILTER, "prefilter"},
+    {VietIntent::STAGE_EXACT, "exact"},
+    {VietIntent::STAGE_CONTAINS, "contains"},
+    {VietIntent::STAGE_KEYWORDS, "keywords"},
+    {VietIntent::STAGE_SIMILARITY, "similarity"},
+    {VietIntent::STAGE_HEURISTICS, "heuristics"},
+    {VietIntent::STAGE_ENTITIES, "entities"}};
+
+std::vector<std::string> stage_names(const VietIntent::IntentResult &r) {
+  std::vector<std::string> names;
+  for (const auto &stage : STAGE_NAMES) {
+    if (r.stages & stage.first)
+      names.push_back(stage.second);
+  }
+  return names;
+}
+
+VietIntent::IntentResult detect_within(VietIntent::IntentEngine &engine,
+                                       const std::string &text,
+                                       double budget_ms) {
+  VietIntent::DetectOptions options;
+  options.budget = std::chrono::microseconds(
+      static_cast<int64_t>(budget_ms * 1000.0));
+  return engine.detect(text, options);
+}
+
+// "full", "fast", "no-entities" -> Pipeline
+std::unique_ptr<VietIntent::IntentEngine>
+engine_with_pipeline(const std::string &name) {
+  if (name == "full")
+    return std::make_unique<VietIntent::IntentEngine>(
+        VietIntent::Pipeline::FULL);
+  if (name == "fast")
+    return std::make_unique<VietIntent::IntentEngine>(
+        VietIntent::Pipeline::FAST);
+  if (name == "no-entities" || name == "no_entities")
+    return std::make_unique<VietIntent::IntentEngine>(
+        VietIntent::Pipeline::NO_ENTITIES);
+  throw py::value_error("unknown pipeline '" + name +
+                        "' (expected 'full', 'fast' or 'no-entities')");
+}
+
+// detect_async: nhận dạng trên ThreadPool (không giữ GIL), kết quả trả về event
+// loop qua call_soon_threadsafe. Mỗi loop có một hàng kết quả; chỉ kết quả đầu
+// tiên của một đợt mới đánh thức loop, các kết quả đến sau đi chung lần drain đó.
+struct LoopQueue : std::enable_shared_from_this<LoopQueue> {
+  struct Done {
+    uint64_t id;
+    VietIntent::IntentResult result;
+    std::string error; // rỗng = thành công
+  };
+
+  // Chỉ truy cập khi giữ GIL
+  py::object loop;
+  std::unordered_map<uint64_t, std::pair<py::object, py::object>>
+      waiting; // id -> (future, engine)
+  uint64_t next_id = 0;
+
+  // Worker ghi vào đây không cần GIL
+  std::mutex mutex;
+  std::vector<Done> done;
+  bool scheduled = false;
+};
+
+// Các đối tượng toàn cục cố ý không hủy: worker có thể còn chạy lúc thoát
+std::unordered_map<PyObject *, std::shared_ptr<LoopQueue>> &loop_queues() {
+  static auto *queues =
+      new std::unordered_map<PyObject *, std::shared_ptr<LoopQueue>>();
+  return *queues;
+}
+
+size_t async_threads = 0; // 0 = số lõi
+VietIntent::ThreadPool *async_pool = nullptr;
+
+VietIntent::ThreadPool &executor() {
+  if (!async_pool)
+    async_pool = new VietIntent::ThreadPool(async_threads);
+  return *async_pool;
+}
+
+void set_async_threads(size_t threads) {
+  if (async_pool)
+    throw std::runtime_error(
+        "set_async_threads must be called before the first detect_async");
+  async_threads = threads;
+}
+
+// Chạy trên thread của event loop: hoàn tất mọi future đã có kết quả
+void drain(const std::shared_ptr<LoopQueue> &queue) {
+  std::vector<LoopQueue::Done> done;
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    done.swap(queue->done);
+    queue->scheduled = false;
+  }
+
+  for (auto &item : done) {
+    auto it = queue->waiting.find(item.id);
+    if (it == queue->waiting.end())
+      continue;
+    py::object future = std::move(it->second.first);
+    queue->waiting.erase(it);
+
+    // Future đã bị hủy (task bị cancel) thì bỏ kết quả
+    try {
+      if (future.attr("done")().cast<bool>())
+        continue;
+      if (item.error.empty()) {
+        future.attr("set_result")(py::cast(std::move(item.result)));
+      } else {
+        future.attr("set_exception")(
+            py::reinterpret_borrow<py::object>(PyExc_RuntimeError)(item.error));
+      }
+    } catch (py::error_already_set &e) {
+      e.discard_as_unraisable("viet_intent.detect_async");
+    }
+  }
+
+  // Không còn yêu cầu nào của loop này: bỏ tham chiếu tới loop
+  if (queue->waiting.empty())
+    loop_queues().erase(queue->loop.ptr());
+}
+
+// Chạy khi giữ GIL, khi lần đánh thức không tới được loop (loop đã đóng): bỏ các
+// kết quả đang chờ cùng future của chúng. Hàng chỉ bị xóa khi không còn worker
+// nào giữ nó, tức là mọi id trong waiting đều đã có kết quả.
+void abandon(LoopQueue *queue) {
+  std::vector<LoopQueue::Done> done;
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    done.swap(queue->done);
+    queue->scheduled = false;
+  }
+  for (const auto &item : done)
+    queue->waiting.erase(item.id);
+
+  if (queue->waiting.empty()) {
+    auto it = loop_queues().find(queue->loop.ptr());
+    if (it != loop_queues().end() && it->second.get() == queue)
+      loop_queues().erase(it);
+  }
+}
+
+// Một lần đánh thức loop. Loop đã đóng thì call_soon_threadsafe báo lỗi, còn
+// loop đóng khi callback đang chờ thì bỏ callback; cả hai trường hợp hủy Wakeup
+// (khi giữ GIL) mà chưa chạy, lúc đó không còn ai nhận kết quả của hàng.
+struct Wakeup {
+  explicit Wakeup(std::shared_ptr<LoopQueue> q) : queue(std::move(q)) {}
+  ~Wakeup() {
+    if (!ran)
+      abandon(queue.get());
+  }
+
+  std::shared_ptr<LoopQueue> queue;
+  bool ran = false;
+};
+
+py::object detect_async(py::object self, const std::string &text,
+                        double budget_ms) {
+  static auto *get_running_loop = new py::object(
+      py::module_::import("asyncio").attr("get_running_loop"));
+
+  auto *engine = self.cast<VietIntent::IntentEngine *>();
+  py::object loop = (*get_running_loop)();
+
+  auto &queue = loop_queues()[loop.ptr()];
+  if (!queue) {
+    queue = std::make_shared<LoopQueue>();
+    queue->loop = loop;
+  }
+
+  py::object future = loop.attr("create_future")();
+  uint64_t id = queue->next_id++;
+  queue->waiting.emplace(id, std::make_pair(future, self));
+
+  VietIntent::DetectOptions options;
+  options.budget =
+      std::chrono::microseconds(static_cast<int64_t>(budget_ms * 1000.0));
+
+  // Worker giữ con trỏ thô: hàng còn sống chừng nào id còn trong waiting
+  LoopQueue *target = queue.get();
+  bool submitted = executor().submit([target, engine, text, options, id] {
+    LoopQueue::Done done{id, {}, {}};
+    try {
+      done.result = engine->detect(text, options);
+    } catch (const std::exception &e) {
+      done.error = e.what();
+      if (done.error.empty())
+        done.error = "detect failed";
+    }
+
+    bool wake;
+    {
+      std::lock_guard<std::mutex> lock(target->mutex);
+      target->done.push_back(std::move(done));
+      wake = !target->scheduled;
+      target->scheduled = true;
+    }
+    if (!wake)
+      return;
+
+    py::gil_scoped_acquire gil;
+    auto wakeup = std::make_shared<Wakeup>(target->shared_from_this());
+    try {
+      target->loop.attr("call_soon_threadsafe")(py::cpp_function([wakeup] {
+        wakeup->ran = true;
+        drain(wakeup->queue);
+      }));
+    } catch (py::error_already_set &) {
+      // Loop đã đóng: Wakeup bị hủy mà chưa chạy
+    }
+  });
+
+  if (!submitted) {
+    queue->waiting.erase(id);
+    throw std::runtime_error("async executor has been shut down");
+  }
+  return future;
+}
+
+} // namespace
+
 PYBIND11_MODULE(viet_intent, m) {
   m.doc() = "Vietnamese Intent Detection Engine";
 
@@ -14,21 +278,227 @@ PYBIND11_MODULE(viet_intent, m) {
       .def_readwrite("entities", &VietIntent::IntentResult::entities)
       .def_readwrite("response_pattern",
                      &VietIntent::IntentResult::response_pattern)
+      .def_readwrite("stages", &VietIntent::IntentResult::stages)
+      .def_readwrite("degraded", &VietIntent::IntentResult::degraded)
+      .def_property_readonly("stage_names", &stage_names)
       .def("__repr__", [](const VietIntent::IntentResult &r) {
         return "<IntentResult intent='" + r.intent +
                "' confidence=" + std::to_string(r.confidence) + ">";
       });
 
-  py::class_<VietIntent::IntentEngine>(m, "IntentEngine")
+  py::class_<VietIntent::IntentSpan, VietIntent::IntentResult>(m, "IntentSpan")
+      .def_readonly("begin", &VietIntent::IntentSpan::begin)
+      .def_readonly("end", &VietIntent::IntentSpan::end)
+      .def_readonly("text", &VietIntent::IntentSpan::text)
+      .def("__repr__", [](const VietIntent::IntentSpan &s) {
+        return "<IntentSpan intent='" + s.intent + "' text='" + s.text +
+               "' confidence=" + std::to_string(s.confidence) + ">";
+      });
+
+  py::class_<VietIntent::DetectionSession>(m, "DetectionSession")
+      .def("append", &VietIntent::DetectionSession::append,
+           py::arg("chunk"), py::return_value_policy::copy)
+      .def("revise", &VietIntent::DetectionSession::revise,
+           py::arg("erase_bytes"), py::arg("replacement") = "",
+           py::return_value_policy::copy)
+      .def("reset", &VietIntent::DetectionSession::reset)
+      .def("current", &VietIntent::DetectionSession::current,
+           py::return_value_policy::copy)
+      .def("result", &VietIntent::DetectionSession::result)
+      .def_property_readonly("text", &VietIntent::DetectionSession::text);
+
+  py::class_<VietIntent::PrefilterConfig>(m, "PrefilterConfig")
       .def(py::init<>())
+      .def_readwrite("enabled", &VietIntent::PrefilterConfig::enabled)
+      .def_readwrite("min_coverage", &VietIntent::PrefilterConfig::min_coverage)
+      .def_readwrite("min_tokens", &VietIntent::PrefilterConfig::min_tokens);
+
+  py::class_<VietIntent::PrefilterStats>(m, "PrefilterStats")
+      .def_readonly("checked", &VietIntent::PrefilterStats::checked)
+      .def_readonly("rejected", &VietIntent::PrefilterStats::rejected)
+      .def("__repr__", [](const VietIntent::PrefilterStats &s) {
+        return "<PrefilterStats checked=" + std::to_string(s.checked) +
+               " rejected=" + std::to_string(s.rejected) + ">";
+      });
+
+  py::enum_<VietIntent::DetectionStage>(m, "DetectionStage", py::arithmetic())
+      .value("PREFILTER", VietIntent::STAGE_PREFILTER)
+      .value("EXACT", VietIntent::STAGE_EXACT)
+      .value("CONTAINS", VietIntent::STAGE_CONTAINS)
+      .value("KEYWORDS", VietIntent::STAGE_KEYWORDS)
+      .value("SIMILARITY", VietIntent::STAGE_SIMILARITY)
+      .value("HEURISTICS", VietIntent::STAGE_HEURISTICS)
+      .value("ENTITIES", VietIntent::STAGE_ENTITIES);
+
+  py::enum_<VietIntent::LoadLevel>(m, "LoadLevel")
+      .value("NORMAL", VietIntent::LoadLevel::NORMAL)
+      .value("ELEVATED", VietIntent::LoadLevel::ELEVATED)
+      .value("CRITICAL", VietIntent::LoadLevel::CRITICAL);
+
+  py::enum_<VietIntent::Pipeline>(m, "Pipeline")
+      .value("FULL", VietIntent::Pipeline::FULL)
+      .value("FAST", VietIntent::Pipeline::FAST)
+      .value("NO_ENTITIES", VietIntent::Pipeline::NO_ENTITIES);
+
+  py::class_<VietIntent::DegradationStats>(m, "DegradationStats")
+      .def_readonly("requests", &VietIntent::DegradationStats::requests)
+      .def_readonly("degraded", &VietIntent::DegradationStats::degraded)
+      .def_readonly("budget_exceeded",
+                    &VietIntent::DegradationStats::budget_exceeded)
+      .def_readonly("similarity_skipped",
+                    &VietIntent::DegradationStats::similarity_skipped)
+      .def_readonly("entities_skipped",
+                    &VietIntent::DegradationStats::entities_skipped)
+      .def("__repr__", [](const VietIntent::DegradationStats &s) {
+        return "<DegradationStats requests=" + std::to_string(s.requests) +
+               " degraded=" + std::to_string(s.degraded) + ">";
+      });
+
+  py::class_<VietIntent::EvaluationStats>(m, "EvaluationStats")
+      .def_readonly("evaluations", &VietIntent::EvaluationStats::evaluations)
+      .def_readonly("intents_scored",
+                    &VietIntent::EvaluationStats::intents_scored)
+      .def_readonly("intents_pruned",
+                    &VietIntent::EvaluationStats::intents_pruned)
+      .def("__repr__", [](const VietIntent::EvaluationStats &s) {
+        return "<EvaluationStats evaluations=" + std::to_string(s.evaluations) +
+               " scored=" + std::to_string(s.intents_scored) +
+               " pruned=" + std::to_string(s.intents_pruned) + ">";
+      });
+
+  py::class_<VietIntent::IntentSpec>(m, "IntentSpec")
+      .def(py::init([](std::string name, std::vector<std::string> patterns,
+                       std::vector<std::string> keywords, double threshold,
+                       std::string response) {
+             VietIntent::IntentSpec spec;
+             spec.name = std::move(name);
+             spec.patterns = std::move(patterns);
+             spec.keywords = std::move(keywords);
+             spec.threshold = threshold;
+             spec.response_pattern = std::move(response);
+             return spec;
+           }),
+           py::arg("name"), py::arg("patterns"),
+           py::arg("keywords") = std::vector<std::string>(),
+           py::arg("threshold") = 0.5, py::arg("response") = "")
+      .def_readwrite("name", &VietIntent::IntentSpec::name)
+      .def_readwrite("patterns", &VietIntent::IntentSpec::patterns)
+      .def_readwrite("keywords", &VietIntent::IntentSpec::keywords)
+      .def_readwrite("threshold", &VietIntent::IntentSpec::threshold)
+      .def_readwrite("response", &VietIntent::IntentSpec::response_pattern);
+
+  py::class_<VietIntent::BuildStats>(m, "BuildStats")
+      .def_readonly("threads", &VietIntent::BuildStats::threads)
+      .def_readonly("intents", &VietIntent::BuildStats::intents)
+      .def_readonly("keys", &VietIntent::BuildStats::keys)
+      .def_readonly("states", &VietIntent::BuildStats::states)
+      .def_readonly("duplicates", &VietIntent::BuildStats::duplicates)
+      .def_readonly("store_ms", &VietIntent::BuildStats::store_ms)
+      .def_readonly("prepare_ms", &VietIntent::BuildStats::prepare_ms)
+      .def_readonly("index_ms", &VietIntent::BuildStats::index_ms)
+      .def_readonly("automaton_ms", &VietIntent::BuildStats::automaton_ms)
+      .def_readonly("total_ms", &VietIntent::BuildStats::total_ms)
+      .def_readonly("fingerprint", &VietIntent::BuildStats::fingerprint)
+      .def("__repr__", [](const VietIntent::BuildStats &s) {
+        return "<BuildStats intents=" + std::to_string(s.intents) +
+               " keys=" + std::to_string(s.keys) +
+               " threads=" + std::to_string(s.threads) +
+               " total_ms=" + std::to_string(s.total_ms) + ">";
+      });
+
+  py::class_<VietIntent::CaptureConfig>(m, "CaptureConfig")
+      .def(py::init<>())
+      .def_readwrite("path", &VietIntent::CaptureConfig::path)
+      .def_readwrite("sample_rate", &VietIntent::CaptureConfig::sample_rate)
+      .def_readwrite("buffer_records",
+                     &VietIntent::CaptureConfig::buffer_records)
+      .def_readwrite("max_file_bytes",
+                     &VietIntent::CaptureConfig::max_file_bytes)
+      .def_readwrite("max_files", &VietIntent::CaptureConfig::max_files)
+      .def_property(
+          "flush_interval_ms",
+          [](const VietIntent::CaptureConfig &c) {
+            return static_cast<int64_t>(c.flush_interval.count());
+          },
+          [](VietIntent::CaptureConfig &c, int64_t ms) {
+            c.flush_interval = std::chrono::milliseconds(ms);
+          });
+
+  py::class_<VietIntent::CaptureStats>(m, "CaptureStats")
+      .def_readonly("captured", &VietIntent::CaptureStats::captured)
+      .def_readonly("dropped", &VietIntent::CaptureStats::dropped)
+      .def_readonly("written", &VietIntent::CaptureStats::written)
+      .def_readonly("rotations", &VietIntent::CaptureStats::rotations)
+      .def("__repr__", [](const VietIntent::CaptureStats &s) {
+        return "<CaptureStats captured=" + std::to_string(s.captured) +
+               " dropped=" + std::to_string(s.dropped) +
+               " written=" + std::to_string(s.written) + ">";
+      });
+
+  py::class_<VietIntent::IntentEngine>(m, "IntentEngine")
+      .def(py::init<VietIntent::Pipeline>(),
+           py::arg("pipeline") = VietIntent::Pipeline::FULL)
+      .def(py::init(&engine_with_pipeline), py::arg("pipeline"))
+      .def_property_readonly("pipeline", &VietIntent::IntentEngine::pipeline)
       .def("initialize", &VietIntent::IntentEngine::initialize,
            py::arg("model_path") = "models/")
-      .def("detect", &VietIntent::IntentEngine::detect)
+      .def("detect",
+           py::overload_cast<const std::string &>(
+               &VietIntent::IntentEngine::detect),
+           py::arg("text"))
+      .def("detect", &detect_within, py::arg("text"), py::arg("budget_ms"))
+      .def("detect_async", &detect_async, py::arg("text"),
+           py::arg("budget_ms") = 0.0,
+           "Detect on the internal thread pool; returns an asyncio future "
+           "of the running loop")
+      .def("detect_batch", &detect_batch, py::arg("texts"),
+           "Detect a list/array of strings; returns columnar NumPy arrays")
+      .def("detect_multi", &VietIntent::IntentEngine::detect_multi,
+           py::call_guard<py::gil_scoped_release>())
+      .def("create_session", &VietIntent::IntentEngine::create_session)
+      .def("set_prefilter", &VietIntent::IntentEngine::set_prefilter)
+      .def("prefilter", &VietIntent::IntentEngine::prefilter)
+      .def("prefilter_stats", &VietIntent::IntentEngine::prefilter_stats)
+      .def("reset_prefilter_stats", &VietIntent::IntentEngine::reset_prefilter_stats)
+      .def("set_load_level", &VietIntent::IntentEngine::set_load_level)
+      .def("load_level", &VietIntent::IntentEngine::load_level)
+      .def("degradation_stats", &VietIntent::IntentEngine::degradation_stats)
+      .def("reset_degradation_stats",
+           &VietIntent::IntentEngine::reset_degradation_stats)
+      .def("start_capture", &VietIntent::IntentEngine::start_capture)
+      .def("stop_capture", &VietIntent::IntentEngine::stop_capture,
+           py::call_guard<py::gil_scoped_release>())
+      .def("capture_stats", &VietIntent::IntentEngine::capture_stats)
+      .def("set_adaptive_order", &VietIntent::IntentEngine::set_adaptive_order)
+      .def("adaptive_order", &VietIntent::IntentEngine::adaptive_order)
+      .def("evaluation_order", &VietIntent::IntentEngine::evaluation_order)
+      .def("load_order_stats", &VietIntent::IntentEngine::load_order_stats)
+      .def("save_order_stats", &VietIntent::IntentEngine::save_order_stats)
+      .def("evaluation_stats", &VietIntent::IntentEngine::evaluation_stats)
+      .def("reset_evaluation_stats",
+           &VietIntent::IntentEngine::reset_evaluation_stats)
       .def("add_intent", &VietIntent::IntentEngine::add_intent)
+      .def("add_intents", &VietIntent::IntentEngine::add_intents,
+           py::arg("specs"), py::arg("threads") = 0,
+           py::call_guard<py::gil_scoped_release>(),
+           "Add many IntentSpec at once and build the model in parallel")
+      .def("build_stats", &VietIntent::IntentEngine::build_stats)
       .def("load_patterns_from_file",
            &VietIntent::IntentEngine::load_patterns_from_file)
       .def("save_patterns", &VietIntent::IntentEngine::save_patterns);
 
+  m.def("set_async_threads", &set_async_threads, py::arg("threads"),
+        "Size of the detect_async thread pool (0 = number of cores); call "
+        "before the first detect_async");
+
+  // Dừng pool trước khi interpreter kết thúc; worker cần GIL để báo kết quả
+  py::module_::import("atexit").attr("register")(py::cpp_function([] {
+    if (async_pool) {
+      py::gil_scoped_release release;
+      async_pool->shutdown();
+    }
+  }));
+
   m.def("create_engine",
         []() { return std::make_unique<VietIntent::IntentEngine>(); });
 }
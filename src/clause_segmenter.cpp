@@ -0,0 +1,93 @@
+#include "clause_segmenter.h"
+#include "text_preprocessor.h"
+#include <cctype>
+#include <cstring>
+
+namespace VietIntent {
+
+namespace {
+
+bool is_space(char c) {
+    return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+bool is_punct(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return u < 128 && std::ispunct(u);
+}
+
+bool is_clause_punct(char c) {
+    return c != '\0' && std::strchr(",.;:!?", c) != nullptr;
+}
+
+bool is_conjunction(const std::string& normalized, const ClauseToken& token) {
+    size_t length = token.norm_end - token.norm_begin;
+    if (length != 2 && length != 3) return false;
+    const char* text = normalized.data() + token.norm_begin;
+    return (length == 2 && std::strncmp(text, "va", 2) == 0) ||
+           (length == 3 && (std::strncmp(text, "roi", 3) == 0 ||
+                            std::strncmp(text, "voi", 3) == 0));
+}
+
+}
+
+Segmentation ClauseSegmenter::segment(const std::string& text) {
+    Segmentation result;
+    std::vector<bool> break_before;
+
+    // Bước 1: chuẩn hóa từng token, ghi nhận dấu câu ở hai đầu
+    bool pending_break = false;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && is_space(text[pos])) ++pos;
+        size_t end = pos;
+        while (end < text.size() && !is_space(text[end])) ++end;
+        if (pos == end) break;
+
+        size_t begin = pos;
+        size_t stop = end;
+        bool leading = false;
+        bool trailing = false;
+        while (begin < stop && is_punct(text[begin])) leading |= is_clause_punct(text[begin++]);
+        while (stop > begin && is_punct(text[stop - 1])) trailing |= is_clause_punct(text[--stop]);
+
+        std::string token = TextPreprocessor::normalize(text.substr(begin, stop - begin));
+        if (token.empty()) {
+            pending_break |= leading || trailing;
+        } else {
+            if (!result.normalized.empty()) result.normalized += ' ';
+            size_t norm_begin = result.normalized.size();
+            result.normalized += token;
+            result.tokens.push_back({begin, stop, norm_begin, result.normalized.size()});
+            break_before.push_back(pending_break || leading);
+            pending_break = trailing;
+        }
+        pos = end;
+    }
+
+    // Bước 2: gom token thành mệnh đề
+    auto close = [&](size_t first, size_t last) {
+        if (first == last) return;
+        const auto& head = result.tokens[first];
+        const auto& tail = result.tokens[last - 1];
+        result.clauses.push_back({first, last, head.begin, tail.end, head.norm_begin, tail.norm_end});
+    };
+
+    size_t first = 0;
+    for (size_t i = 0; i < result.tokens.size(); ++i) {
+        if (break_before[i]) {
+            close(first, i);
+            first = i;
+        }
+        bool followed = i + 1 < result.tokens.size() && !break_before[i + 1];
+        if (followed && is_conjunction(result.normalized, result.tokens[i])) {
+            close(first, i);
+            first = i + 1;
+        }
+    }
+    close(first, result.tokens.size());
+
+    return result;
+}
+
+}
@@ -1,15 +1,1167 @@
 #include "intent_detector.h"
 #include "viet_intent.h"
 #include "text_preprocessor.h"
+#include "pattern_matcher.h"
+#include "number_parser.h"
+#include "clause_segmenter.h"
+#include "query_capture.h"
+#include "intent_order.h"
+#include "thread_pool.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
 #include <cmath>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <cstring>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace VietIntent {
 
+namespace {
+
+// Các chuỗi phục vụ luật đặc biệt (bonus greeting, phạt goodbye, heuristic)
+enum Probe {
+    PROBE_CHAO, PROBE_XIN, PROBE_HELLO, PROBE_HI,
+    PROBE_TAM_BIET, PROBE_BYE, PROBE_GOODBYE,
+    PROBE_CAM_ON, PROBE_THANKS,
+    PROBE_GIA, PROBE_TIEN, PROBE_BAO_NHIEU,
+    PROBE_GIO, PROBE_MAY_GIO,
+    PROBE_XIN_CHAO,
+    PROBE_COUNT
+};
+
+const char* const PROBE_TEXT[PROBE_COUNT] = {
+    "chao", "xin", "hello", "hi",
+    "tam biet", "bye", "goodbye",
+    "cam on", "thanks",
+    "gia", "tien", "bao nhieu",
+    "gio", "may gio",
+    "xin chao"
+};
+
+// Thứ tự đánh giá intent (intent có điểm bằng nhau thì intent đứng trước thắng);
+// intent thêm vào qua add_intent/add_intents đứng sau, theo thứ tự tên
+const std::vector<std::string> INTENT_ORDER = {
+    "greeting", "order_food", "ask_price", "ask_time", "thank_you", "goodbye"
+};
+
+enum HitKind : uint8_t { HIT_PATTERN, HIT_KEYWORD, HIT_FIRST_PATTERN, HIT_PROBE };
+
+// Ý nghĩa của một khóa trong automaton đối với một intent (hoặc probe)
+struct KeyHit {
+    HitKind kind;
+    int target;       // chỉ số intent, hoặc Probe
+    int weight = 0;   // keyword: số lần keyword xuất hiện trong danh sách
+    int bonus = 0;    // keyword: số lần được cộng bonus greeting
+};
+
+struct CompiledIntent {
+    std::string name;
+    double threshold = 0.5;
+    bool is_greeting = false;
+    bool is_goodbye = false;
+
+    // Bước 4: so sánh với pattern đầu tiên
+    bool has_similarity = false;
+    std::string first_pattern;
+    size_t first_pattern_tokens = 0;
+    uint64_t first_pattern_bytes = 0;   // byte_mask(first_pattern)
+
+    // Cận trên tĩnh của điểm cuối; -1 nếu không bao giờ đạt ngưỡng
+    double upper_bound = 1.0;
+};
+
+// Stopwords tiếng Việt
+const std::vector<std::string> STOPWORDS = {
+    "la", "cua", "va", "co", "duoc", "trong", "toi", "ban",
+    "anh", "chi", "ong", "ba", "nay", "kia", "do", "a", "oi", "mot",
+    "hai", "ba", "bon", "nam", "sau", "bay", "tam", "chin", "muoi",
+    "cai", "con", "nguoi", "no", "nhung", "cac", "hay", "hoac",
+    "nhung", "rat", "qua", "nhieu", "it", "voi", "len", "xuong"
+};
+
+// Lượng từ / đơn vị ("hai phần", "một ly"): không tính vào độ phủ từ vựng
+const std::vector<std::string> UNIT_WORDS = {
+    "phan", "suat", "ly", "coc", "chai", "lon", "to", "dia", "bat", "chen",
+    "hop", "goi", "chiec", "cai", "kg", "lit", "trai", "xuat"
+};
+
+// Tên món ăn / mặt hàng dùng khi trích xuất thực thể
+const std::vector<std::string> FOOD_ITEMS = {
+    "pho", "phở", "bun", "bún", "com", "cơm", "banh", "bánh",
+    "cha", "chả", "nem", "banh mi", "bánh mì", "bun cha", "bún chả",
+    "pho bo", "phở bò", "pho ga", "phở gà", "bun bo", "bún bò",
+    "com tam", "cơm tấm", "banh xeo", "bánh xèo", "goi cuon", "gỏi cuốn",
+    "banh canh", "bánh canh", "hu tieu", "hủ tiếu", "mi", "mì",
+    "banh cuon", "bánh cuốn", "xoi", "xôi", "che", "chè"
+};
+
+const std::vector<std::string> PRICE_ITEMS = {
+    "pho", "phở", "bun", "bún", "com", "cơm", "banh", "bánh",
+    "banh mi", "bánh mì", "ca phe", "cà phê", "tra da", "trà đá",
+    "ao", "áo", "quan", "quần", "dien thoai", "điện thoại",
+    "may tinh", "máy tính", "xe may", "xe máy", "oto", "ô tô",
+    "tu lanh", "tủ lạnh", "tivi", "tv", "laptop"
+};
+
+// FNV-1a + trộn bit (splitmix64) để hai nửa 32 bit dùng làm hai hàm băm
+uint64_t hash_token(std::string_view token) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : token) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+// Tập byte của chuỗi theo 6 bit thấp (a ⊂ b => mask(a) ⊂ mask(b))
+uint64_t byte_mask(std::string_view text) {
+    uint64_t mask = 0;
+    for (unsigned char c : text) mask |= 1ULL << (c & 63);
+    return mask;
+}
+
+// Mục từ vựng chỉ gồm một token nội dung
+uint64_t hash_word(uint64_t token) {
+    return token ^ 0x5851f42d4c957f2dULL;
+}
+
+uint64_t hash_bigram(uint64_t first, uint64_t second) {
+    return hash_token(std::string_view(reinterpret_cast<const char*>(&first), sizeof(first))) ^
+           (second * 0x9e3779b97f4a7c15ULL);
+}
+
+// Bloom filter trên hash token/bigram của từ vựng model. Số bit và số hàm băm
+// tính theo số mục lúc dựng model (~1% dương tính giả), nên model lớn không làm
+// bộ lọc đầy bit và mất tác dụng.
+class VocabularyFilter {
+public:
+    void reserve(size_t entries) {
+        size_t bits = 64;
+        while (bits < entries * BITS_PER_ENTRY) bits <<= 1;
+        words.assign(bits / 64, 0);
+        mask = bits - 1;
+        // Số hàm băm tối ưu: (bit / mục) * ln 2
+        double per_entry = static_cast<double>(bits) / std::max<size_t>(entries, 1);
+        hashes = static_cast<int>(std::lround(per_entry * 0.6931));
+        hashes = std::min(std::max(hashes, 1), MAX_HASHES);
+    }
+
+    void add(uint64_t h) {
+        for (int i = 0; i < hashes; ++i) {
+            size_t bit = position(h, i);
+            words[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+
+    bool contains(uint64_t h) const {
+        for (int i = 0; i < hashes; ++i) {
+            size_t bit = position(h, i);
+            if ((words[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr size_t BITS_PER_ENTRY = 10;
+    static constexpr int MAX_HASHES = 12;
+
+    // Băm kép: vị trí thứ i = h1 + i * h2 (h2 lẻ)
+    size_t position(uint64_t h, int i) const {
+        uint64_t h1 = h & 0xffffffffULL;
+        uint64_t h2 = (h >> 32) | 1;
+        return static_cast<size_t>((h1 + static_cast<uint64_t>(i) * h2) & mask);
+    }
+
+    std::vector<uint64_t> words = std::vector<uint64_t>(1, 0);
+    size_t mask = 63;
+    int hashes = 1;
+};
+
+// Model đã biên dịch: bất biến, chia sẻ giữa detect() và các DetectionSession
+struct CompiledModel {
+    PatternMatcher matcher;
+    std::vector<uint32_t> hit_begin;
+    std::vector<KeyHit> hits;
+    std::vector<CompiledIntent> intents;
+    std::map<std::string, std::string> responses;
+
+    // Lượt thắng theo intent và thứ tự chấm điểm thích nghi (chỉ số trong intents)
+    std::shared_ptr<AdaptiveOrder> traffic;
+
+    // Token của pattern đầu tiên -> các intent chứa token đó (tính Jaccard)
+    std::unordered_map<std::string, int> token_ids;
+    std::vector<std::vector<int>> token_intents;
+
+    // Từ vựng cho bộ lọc ngoài miền
+    VocabularyFilter vocabulary;
+    std::unordered_set<uint64_t> stopwords;     // kể cả lượng từ / đơn vị
+    std::unordered_set<uint64_t> dish_heads;    // token đầu của tên món (FOOD_ITEMS)
+    std::unordered_set<uint64_t> unit_words;    // lượng từ / đơn vị (UNIT_WORDS)
+
+    // Token nội dung: không phải stopword, không bắt đầu bằng chữ số (số lượng, giá...)
+    bool is_content(std::string_view token, uint64_t h) const {
+        return !token.empty() && !std::isdigit(static_cast<unsigned char>(token[0])) &&
+               stopwords.count(h) == 0;
+    }
+
+    template <typename Fn>
+    void for_each_hit(int key, Fn&& fn) const {
+        for (uint32_t i = hit_begin[key]; i < hit_begin[key + 1]; ++i) {
+            fn(hits[i]);
+        }
+    }
+};
+
+// Độ phủ từ vựng: tỷ lệ token nội dung của câu được "neo" vào model, tức là
+// tự nó là một mục từ vựng (keyword một từ, tên món...) hoặc ghép với token
+// kề bên thành một bigram có trong model. Âm tiết lẻ như "khach", "xe" không
+// đủ để coi câu là trong miền. Token nội dung liền sau tên món được coi là
+// phần mô tả món ("cơm gà xối mỡ") và cũng được neo; token nội dung liền sau
+// lượng từ là tên món/đồ uống ("một ly trà sữa trân châu") nên cũng vậy.
+struct Coverage {
+    size_t tokens = 0;
+    size_t anchored = 0;
+    uint64_t last = 0;
+    bool last_anchored = false;
+    bool in_dish = false;
+
+    void add(const CompiledModel& m, std::string_view token) {
+        uint64_t h = hash_token(token);
+        if (!m.is_content(token, h)) {
+            in_dish = m.unit_words.count(h) > 0;
+            return;
+        }
+
+        bool known = m.vocabulary.contains(hash_word(h));
+        if (tokens > 0 && m.vocabulary.contains(hash_bigram(last, h))) {
+            if (!last_anchored) ++anchored;
+            known = true;
+        }
+        bool dish = m.dish_heads.count(h) > 0;
+        if (dish || in_dish) known = true;
+        if (known) ++anchored;
+
+        ++tokens;
+        last = h;
+        last_anchored = known;
+        in_dish = dish || in_dish;
+    }
+
+    double score() const {
+        return tokens == 0 ? 1.0 : static_cast<double>(anchored) / tokens;
+    }
+};
+
+Coverage measure_coverage(const CompiledModel& m, const std::string& normalized) {
+    Coverage coverage;
+    std::string_view text(normalized);
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(' ', start);
+        if (end == std::string_view::npos) end = text.size();
+        coverage.add(m, text.substr(start, end - start));
+        start = end + 1;
+    }
+    return coverage;
+}
+
+bool out_of_domain(const Coverage& coverage, const PrefilterConfig& config) {
+    return config.enabled && coverage.tokens >= config.min_tokens &&
+           coverage.score() < config.min_coverage;
+}
+
+// Phần của một intent tính được độc lập với các intent khác (bước song song)
+struct PreparedKeyword {
+    std::string key;
+    int weight = 0;
+    int bonus = 0;
+};
+
+struct PreparedIntent {
+    CompiledIntent intent;
+    std::vector<std::string> patterns;          // đã chuẩn hóa, bỏ rỗng và trùng
+    std::vector<PreparedKeyword> keywords;      // keyword trùng được cộng dồn
+    std::vector<std::string> first_tokens;
+    std::vector<uint64_t> vocabulary;           // hash token/bigram nội dung
+    size_t duplicates = 0;
+};
+
+// Hash token và bigram nội dung của text cho từ vựng model
+void collect_vocabulary(const CompiledModel& m, const std::string& text, std::vector<uint64_t>& out) {
+    uint64_t last = 0;
+    size_t count = 0;
+    for (const auto& token : TextPreprocessor::tokenize(text)) {
+        uint64_t h = hash_token(token);
+        if (!m.is_content(token, h)) continue;
+        if (count > 0) out.push_back(hash_bigram(last, h));
+        last = h;
+        ++count;
+    }
+    if (count == 1) out.push_back(hash_word(last));
+}
+
+PreparedIntent prepare_intent(const CompiledModel& m, const std::string& name,
+                              const IntentPattern& pattern) {
+    PreparedIntent prepared;
+    CompiledIntent& intent = prepared.intent;
+    intent.name = name;
+    intent.threshold = pattern.threshold;
+    intent.is_greeting = name == "greeting";
+    intent.is_goodbye = name == "goodbye";
+
+    std::unordered_set<std::string> seen;
+    for (const auto& pattern_text : pattern.patterns) {
+        collect_vocabulary(m, pattern_text, prepared.vocabulary);
+        std::string normalized = TextPreprocessor::normalize(pattern_text);
+        if (normalized.empty()) continue;
+        if (seen.insert(normalized).second) {
+            prepared.patterns.push_back(std::move(normalized));
+        } else {
+            ++prepared.duplicates;
+        }
+    }
+
+    std::unordered_map<std::string, size_t> keyword_index;
+    int keyword_weight = 0;
+    int keyword_bonus = 0;
+    for (const auto& pattern_keyword : pattern.keywords) {
+        collect_vocabulary(m, pattern_keyword, prepared.vocabulary);
+        std::string normalized_keyword = TextPreprocessor::normalize(pattern_keyword);
+        if (normalized_keyword.empty()) continue;
+        int bonus = (intent.is_greeting &&
+                    (normalized_keyword == "xin" || normalized_keyword == "chao")) ? 1 : 0;
+        keyword_weight += 1;
+        keyword_bonus += bonus;
+
+        auto [it, inserted] = keyword_index.emplace(normalized_keyword, prepared.keywords.size());
+        if (inserted) {
+            prepared.keywords.push_back({std::move(normalized_keyword), 1, bonus});
+        } else {
+            prepared.keywords[it->second].weight += 1;
+            prepared.keywords[it->second].bonus += bonus;
+            ++prepared.duplicates;
+        }
+    }
+
+    // Cận trên tĩnh: có pattern thì trùng khớp hoàn toàn đạt 1.0; chỉ có keyword
+    // thì mọi keyword cùng xuất hiện (cộng thêm sai số làm tròn)
+    if (prepared.patterns.empty()) {
+        double bound = std::min(1.0, 0.5 * keyword_bonus + 0.3 * (keyword_weight - keyword_bonus));
+        bound = std::min(1.0, bound + keyword_weight * 0.1);
+        if (intent.is_greeting) bound = std::max(bound, 0.9);
+        intent.upper_bound = bound + 1e-9;
+    }
+    if (intent.upper_bound < intent.threshold) intent.upper_bound = -1.0;
+
+    if (!pattern.patterns.empty() && pattern.patterns[0].length() > 5) {
+        intent.has_similarity = true;
+        intent.first_pattern = TextPreprocessor::normalize(pattern.patterns[0]);
+        intent.first_pattern_bytes = byte_mask(intent.first_pattern);
+        prepared.first_tokens = TextPreprocessor::tokenize(intent.first_pattern);
+        intent.first_pattern_tokens = prepared.first_tokens.size();
+    }
+    return prepared;
+}
+
+// Băm nội dung model (khóa, hit, intent) để kiểm tra hai lần dựng cho cùng kết quả
+uint64_t model_fingerprint(const CompiledModel& m) {
+    uint64_t h = 1469598103934665603ULL;
+    auto mix = [&](uint64_t value) { h = (h ^ value) * 1099511628211ULL; };
+    auto mix_text = [&](const std::string& text) { mix(hash_token(text)); };
+
+    for (size_t id = 0; id < m.matcher.key_count(); ++id) mix_text(m.matcher.key(id));
+    for (uint32_t begin : m.hit_begin) mix(begin);
+    for (const auto& hit : m.hits) {
+        mix(hit.kind);
+        mix(static_cast<uint64_t>(hit.target));
+        mix(static_cast<uint64_t>(hit.weight));
+        mix(static_cast<uint64_t>(hit.bonus));
+    }
+    for (const auto& intent : m.intents) {
+        mix_text(intent.name);
+        mix_text(intent.first_pattern);
+        mix(static_cast<uint64_t>(std::llround(intent.threshold * 1e9)));
+        mix(static_cast<uint64_t>(std::llround(intent.upper_bound * 1e9)));
+    }
+    for (const auto& owners : m.token_intents) {
+        for (int owner : owners) mix(static_cast<uint64_t>(owner));
+        mix(~0ULL);
+    }
+    return h;
+}
+
+// Thời gian từ since đến giờ (ms), rồi dời since về hiện tại
+double lap_ms(std::chrono::steady_clock::time_point& since) {
+    auto now = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(now - since).count();
+    since = now;
+    return ms;
+}
+
+// Biên dịch model cho biến thể pipeline P. Intent có sẵn theo INTENT_ORDER, intent
+// thêm vào theo thứ tự tên. Bước chuẩn hóa chạy song song trên pool (nếu có); bước
+// gộp đi theo thứ tự intent nên id khóa, danh sách hit và từ vựng không phụ thuộc
+// số thread. Khóa mà P không dùng (probe, pattern đầu tiên) không được thêm vào.
+template <class P>
+std::shared_ptr<const CompiledModel> compile_model(
+        const std::map<std::string, IntentPattern>& intent_patterns,
+        const std::map<std::string, std::string>& response_patterns,
+        ThreadPool* pool, BuildStats& stats) {
+    auto clock = std::chrono::steady_clock::now();
+    auto model = std::make_shared<CompiledModel>();
+    model->responses = response_patterns;
+    for (const auto& word : STOPWORDS) {
+        model->stopwords.insert(hash_token(word));
+    }
+    for (const auto& word : UNIT_WORDS) {
+        model->stopwords.insert(hash_token(word));
+        model->unit_words.insert(hash_token(word));
+    }
+    for (const auto& item : FOOD_ITEMS) {
+        auto tokens = TextPreprocessor::tokenize(item);
+        if (!tokens.empty()) model->dish_heads.insert(hash_token(tokens[0]));
+    }
+
+    std::vector<const std::pair<const std::string, IntentPattern>*> sources;
+    for (const auto& intent_name : INTENT_ORDER) {
+        auto it = intent_patterns.find(intent_name);
+        if (it != intent_patterns.end()) sources.push_back(&*it);
+    }
+    for (const auto& entry : intent_patterns) {
+        if (std::find(INTENT_ORDER.begin(), INTENT_ORDER.end(), entry.first) == INTENT_ORDER.end()) {
+            sources.push_back(&entry);
+        }
+    }
+
+    // Bước 1: chuẩn hóa, tách token, bỏ trùng từng intent
+    std::vector<PreparedIntent> prepared(sources.size());
+    auto prepare = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            prepared[i] = prepare_intent(*model, sources[i]->first, sources[i]->second);
+        }
+    };
+    if (pool) {
+        pool->parallel_for(sources.size(), prepare);
+    } else {
+        prepare(0, sources.size());
+    }
+    stats.prepare_ms = lap_ms(clock);
+
+    // Bước 2: gộp theo thứ tự intent. Trong một intent khóa đã không trùng
+    // (theo loại hit), nên mỗi hit chỉ cần nối vào danh sách của khóa.
+    std::vector<std::vector<KeyHit>> key_hits;
+    auto add_hit = [&](const std::string& key, const KeyHit& hit) {
+        size_t id = static_cast<size_t>(model->matcher.add(key));
+        if (id >= key_hits.size()) key_hits.resize(id + 1);
+        key_hits[id].push_back(hit);
+    };
+
+    if constexpr (P::Heuristics::enabled) {
+        for (int p = 0; p < PROBE_COUNT; ++p) {
+            add_hit(PROBE_TEXT[p], {HIT_PROBE, p});
+        }
+    }
+
+    // Từ vựng gồm token và bigram nội dung của mọi pattern/keyword và tên thực thể
+    std::vector<uint64_t> vocabulary;
+    for (const auto& text : FOOD_ITEMS) collect_vocabulary(*model, text, vocabulary);
+    for (const auto& text : PRICE_ITEMS) collect_vocabulary(*model, text, vocabulary);
+    size_t vocabulary_entries = vocabulary.size();
+    for (const auto& entry : prepared) vocabulary_entries += entry.vocabulary.size();
+    model->vocabulary.reserve(vocabulary_entries);
+    for (uint64_t h : vocabulary) model->vocabulary.add(h);
+
+    stats.duplicates = 0;
+    for (auto& entry : prepared) {
+        int index = static_cast<int>(model->intents.size());
+        for (uint64_t h : entry.vocabulary) model->vocabulary.add(h);
+        for (const auto& key : entry.patterns) add_hit(key, {HIT_PATTERN, index});
+        for (const auto& keyword : entry.keywords) {
+            add_hit(keyword.key, {HIT_KEYWORD, index, keyword.weight, keyword.bonus});
+        }
+
+        if (P::Scorer::similarity && entry.intent.has_similarity) {
+            for (const auto& token : entry.first_tokens) {
+                auto [tok, inserted] = model->token_ids.emplace(
+                    token, static_cast<int>(model->token_intents.size()));
+                if (inserted) model->token_intents.emplace_back();
+                auto& owners = model->token_intents[tok->second];
+                if (owners.empty() || owners.back() != index) owners.push_back(index);
+            }
+            if (!entry.intent.first_pattern.empty()) {
+                add_hit(entry.intent.first_pattern, {HIT_FIRST_PATTERN, index});
+            }
+        }
+
+        stats.duplicates += entry.duplicates;
+        model->intents.push_back(std::move(entry.intent));
+    }
+    prepared.clear();
+    prepared.shrink_to_fit();
+
+    key_hits.resize(model->matcher.key_count());
+    model->hit_begin.reserve(key_hits.size() + 1);
+    for (const auto& list : key_hits) {
+        model->hit_begin.push_back(static_cast<uint32_t>(model->hits.size()));
+        model->hits.insert(model->hits.end(), list.begin(), list.end());
+    }
+    model->hit_begin.push_back(static_cast<uint32_t>(model->hits.size()));
+
+    std::vector<double> upper_bounds;
+    for (const auto& intent : model->intents) upper_bounds.push_back(intent.upper_bound);
+    model->traffic = std::make_shared<AdaptiveOrder>(std::move(upper_bounds));
+    stats.index_ms = lap_ms(clock);
+
+    // Bước 3: automaton
+    model->matcher.build();
+    stats.automaton_ms = lap_ms(clock);
+
+    stats.threads = pool ? pool->size() : 1;
+    stats.intents = model->intents.size();
+    stats.keys = model->matcher.key_count();
+    stats.states = model->matcher.state_count();
+    stats.fingerprint = model_fingerprint(*model);
+    return model;
+}
+
+// Mốc hoàn tác của MatchState
+struct MatchMark {
+    int state;
+    size_t length;
+    size_t tokens;
+    size_t log_size;
+    Coverage coverage;
+};
+
+// Trạng thái so khớp trên văn bản chuẩn hóa theo biến thể pipeline P, cập nhật
+// theo từng token. Chỉ các bộ đếm mà P chấm điểm mới được cấp phát và cập nhật.
+// Khi bật ghi log, mọi thay đổi có thể hoàn tác về một mốc (sửa phần cuối câu).
+template <class P>
+class MatchState {
+public:
+    using Mark = MatchMark;
+
+    static constexpr bool count_contains = P::Scorer::contains;
+    static constexpr bool count_first_pattern = P::Scorer::similarity;
+    static constexpr bool count_probes = P::Heuristics::enabled;
+
+    explicit MatchState(const CompiledModel& m, bool record = false)
+        : model(&m),
+          contains(count_contains ? m.intents.size() : 0, 0),
+          keyword_matches(m.intents.size(), 0),
+          keyword_bonus(m.intents.size(), 0),
+          first_pattern_found(count_first_pattern ? m.intents.size() : 0, 0),
+          common_tokens(P::Matcher::track_tokens ? m.intents.size() : 0, 0),
+          recording(record),
+          key_count(m.matcher.key_count(), 0) {}
+
+    // Nạp một token đã chuẩn hóa (không chứa khoảng trắng). Matcher không đếm token
+    // thì bỏ việc đếm token chung với pattern đầu tiên (chỉ bước độ tương đồng dùng)
+    void feed_token(const std::string& token) {
+        if (token.empty()) return;
+        if (length > 0) feed_byte(' ');
+        for (unsigned char c : token) feed_byte(c);
+
+        if constexpr (P::Matcher::track_tokens) {
+            auto it = model->token_ids.find(token);
+            int id = it == model->token_ids.end() ? -1 : it->second;
+            apply_token(id, +1);
+            if (recording) log.push_back({EVENT_TOKEN, id});
+        }
+        ++tokens;
+        // detect() đo độ phủ trước khi chạy automaton; phiên tăng dần đo tại đây
+        if (recording) coverage.add(*model, token);
+    }
+
+    Mark mark() const { return {state, length, tokens, log.size(), coverage}; }
+
+    void rollback(const Mark& m) {
+        while (log.size() > m.log_size) {
+            Event e = log.back();
+            log.pop_back();
+            if (e.kind == EVENT_KEY) {
+                if (--key_count[e.id] == 0) apply_key(e.id, -1);
+            } else {
+                apply_token(e.id, -1);
+            }
+        }
+        state = m.state;
+        length = m.length;
+        tokens = m.tokens;
+        coverage = m.coverage;
+    }
+
+    const CompiledModel* model;
+    int state = PatternMatcher::ROOT;
+    size_t length = 0;
+    size_t tokens = 0;
+    Coverage coverage;
+
+    std::vector<int> contains;
+    std::vector<int> keyword_matches;
+    std::vector<int> keyword_bonus;
+    std::vector<int> first_pattern_found;
+    std::vector<int> common_tokens;
+    int probes[PROBE_COUNT] = {};
+
+private:
+    enum EventKind : uint8_t { EVENT_KEY, EVENT_TOKEN };
+    struct Event {
+        EventKind kind;
+        int id;
+    };
+
+    void feed_byte(unsigned char c) {
+        state = model->matcher.step(state, c);
+        ++length;
+        model->matcher.for_each_match(state, [&](int key) {
+            if (key_count[key]++ == 0) apply_key(key, +1);
+            if (recording) log.push_back({EVENT_KEY, key});
+        });
+    }
+
+    void apply_key(int key, int delta) {
+        [[maybe_unused]] size_t key_length = model->matcher.key_length(key);
+        model->for_each_hit(key, [&](const KeyHit& hit) {
+            switch (hit.kind) {
+                case HIT_PATTERN:
+                    if constexpr (count_contains) {
+                        if (key_length > 2) contains[hit.target] += delta;  // Chỉ xét pattern dài hơn 2 ký tự
+                    }
+                    break;
+                case HIT_KEYWORD:
+                    keyword_matches[hit.target] += delta * hit.weight;
+                    keyword_bonus[hit.target] += delta * hit.bonus;
+                    break;
+                case HIT_FIRST_PATTERN:
+                    if constexpr (count_first_pattern) first_pattern_found[hit.target] += delta;
+                    break;
+                case HIT_PROBE:
+                    if constexpr (count_probes) probes[hit.target] += delta;
+                    break;
+            }
+        });
+    }
+
+    void apply_token(int id, int delta) {
+        if (id < 0) return;
+        for (int intent : model->token_intents[id]) {
+            common_tokens[intent] += delta;
+        }
+    }
+
+    bool recording;
+    std::vector<uint32_t> key_count;
+    std::vector<Event> log;
+};
+
+// Nạp toàn bộ chuỗi đã chuẩn hóa vào state
+template <class P>
+void feed_normalized(MatchState<P>& state, const std::string& normalized) {
+    std::string token;
+    for (char c : normalized) {
+        if (c == ' ') {
+            state.feed_token(token);
+            token.clear();
+        } else {
+            token += c;
+        }
+    }
+    state.feed_token(token);
+}
+
+struct Evaluation {
+    std::string intent = "unknown";
+    double confidence = 0.0;
+    int index = -1;        // intent thắng vòng chấm điểm (trước heuristic), -1 nếu không có
+    uint32_t scored = 0;   // số intent được chấm điểm (không bị cắt tỉa)
+};
+
+void extract_entities(const std::string& normalized, const std::string& intent,
+                      std::map<std::string, std::string>& entities);
+
+// ---------------------------------------------------------------------------
+// Policy của pipeline nhận dạng. Mỗi biến thể (Pipeline) là một tổ hợp policy;
+// bước bị tắt được loại bỏ lúc biên dịch bằng if constexpr.
+// ---------------------------------------------------------------------------
+
+// Matcher: automaton luôn chạy; TokenMatcher đếm thêm token cho bước độ tương đồng
+struct TokenMatcher {
+    static constexpr bool track_tokens = true;
+};
+
+struct KeyMatcher {
+    static constexpr bool track_tokens = false;
+};
+
+// Scorer: exact và keyword luôn chạy
+struct FullScorer {
+    static constexpr bool contains = true;
+    static constexpr bool similarity = true;
+};
+
+struct ExactKeywordScorer {
+    static constexpr bool contains = false;
+    static constexpr bool similarity = false;
+};
+
+// Heuristics: thưởng greeting, phạt goodbye, heuristic khi điểm thấp, ép "xin chao"/"cam on"
+struct RuleHeuristics {
+    static constexpr bool enabled = true;
+};
+
+struct NoHeuristics {
+    static constexpr bool enabled = false;
+};
+
+// Entity extractor
+struct StandardEntities {
+    static constexpr bool enabled = true;
+
+    static void extract(const std::string& normalized, const std::string& intent,
+                        std::map<std::string, std::string>& entities) {
+        extract_entities(normalized, intent, entities);
+    }
+};
+
+struct NoEntities {
+    static constexpr bool enabled = false;
+
+    static void extract(const std::string&, const std::string&,
+                        std::map<std::string, std::string>&) {}
+};
+
+// Tracing: dòng [DEBUG] ra std::cout
+struct DebugTrace {
+    template <typename... Args>
+    static void line(const Args&... args) {
+        (std::cout << ... << args) << std::endl;
+    }
+};
+
+struct NoTrace {
+    template <typename... Args>
+    static void line(const Args&...) {}
+};
+
+template <class MatcherPolicy, class ScorerPolicy, class HeuristicsPolicy,
+          class EntitiesPolicy, class TracePolicy>
+struct PipelinePolicy {
+    using Matcher = MatcherPolicy;
+    using Scorer = ScorerPolicy;
+    using Heuristics = HeuristicsPolicy;
+    using Entities = EntitiesPolicy;
+    using Trace = TracePolicy;
+
+    static_assert(!Scorer::similarity || Matcher::track_tokens,
+                  "similarity scoring needs token tracking");
+
+    // Các bước chấm điểm (không gồm prefilter, thực thể) mà biến thể này chạy
+    static constexpr uint32_t scoring_stages =
+        STAGE_EXACT | STAGE_KEYWORDS |
+        (Scorer::contains ? STAGE_CONTAINS : 0u) |
+        (Scorer::similarity ? STAGE_SIMILARITY : 0u) |
+        (Heuristics::enabled ? STAGE_HEURISTICS : 0u);
+
+    template <class OtherTrace>
+    using WithTrace = PipelinePolicy<Matcher, Scorer, Heuristics, Entities, OtherTrace>;
+};
+
+using FullPipeline =
+    PipelinePolicy<TokenMatcher, FullScorer, RuleHeuristics, StandardEntities, DebugTrace>;
+using FastPipeline =
+    PipelinePolicy<KeyMatcher, ExactKeywordScorer, NoHeuristics, NoEntities, NoTrace>;
+using NoEntitiesPipeline =
+    PipelinePolicy<TokenMatcher, FullScorer, RuleHeuristics, NoEntities, NoTrace>;
+
+// Cùng biến thể nhưng không in debug (batch, phiên, detect_multi)
+template <class P>
+using Silent = typename P::template WithTrace<NoTrace>;
+
+// Tính điểm các intent từ state hiện tại theo policy P; normalized là toàn bộ chuỗi
+// đã nạp. Intent được chấm theo order và dừng khi không intent còn lại nào thắng
+// được (hòa điểm thì intent trùng khớp hoàn toàn thắng, rồi đến intent đứng trước
+// trong model, nên kết quả không phụ thuộc thứ tự). with_similarity = false bỏ qua
+// bước 4 (chế độ giảm tải);
+// scores != nullptr ghi điểm từng bước cho capture; cắt tỉa vẫn bật nên chỉ có
+// điểm của các intent thực sự được chấm
+template <class P>
+Evaluation evaluate(const MatchState<P>& s, const std::string& normalized, const IntentOrder& order,
+                    bool with_similarity = true, CaptureScores* scores = nullptr) {
+    using Trace = typename P::Trace;
+    const CompiledModel& model = *s.model;
+    const size_t n = model.intents.size();
+
+    // Khóa kết thúc tại cuối chuỗi và dài bằng cả chuỗi => trùng khớp hoàn toàn
+    std::vector<char> exact(n, 0);
+    std::vector<size_t> exact_hits;
+    bool probe_exact[PROBE_COUNT] = {};
+    model.matcher.for_each_match(s.state, [&](int key) {
+        if (model.matcher.key_length(key) != s.length) return;
+        model.for_each_hit(key, [&](const KeyHit& hit) {
+            if (hit.kind == HIT_PATTERN && !exact[hit.target]) {
+                exact[hit.target] = 1;
+                exact_hits.push_back(hit.target);
+            }
+            if (hit.kind == HIT_PROBE) probe_exact[hit.target] = true;
+        });
+    });
+
+    auto has = [&](Probe p) { return s.probes[p] > 0; };
+
+    Evaluation best;
+    bool best_exact = false;   // best trùng khớp hoàn toàn một pattern
+
+    // Điểm score của intent i có thắng best hiện tại không. Hòa điểm thì intent
+    // trùng khớp hoàn toàn thắng, rồi đến intent đứng trước trong model
+    auto beats = [&](double score, size_t i) {
+        if (score != best.confidence) return score > best.confidence;
+        if (best.index < 0) return false;
+        if (exact[i] != static_cast<char>(best_exact)) return exact[i] != 0;
+        return i < static_cast<size_t>(best.index);
+    };
+
+    // Giới hạn điểm và cộng điểm theo số keyword (bước cuối của exact/contains/keyword/độ tương đồng)
+    auto with_keywords = [](double score, int keyword_matches) {
+        if (score > 1.0) score = 1.0;
+        if (keyword_matches > 0) {
+            score += keyword_matches * 0.1;
+        }
+        if (score > 1.0) score = 1.0;
+        return score;
+    };
+
+    // Luật riêng cho greeting và goodbye
+    auto apply_rules = [&](const CompiledIntent& intent, double score, bool trace) {
+        if constexpr (P::Heuristics::enabled) {
+            // ĐẶC BIỆT: Nếu là greeting và có từ "chao" hoặc "xin", ưu tiên cao
+            if (intent.is_greeting &&
+                (has(PROBE_CHAO) || has(PROBE_XIN) || has(PROBE_HELLO) || has(PROBE_HI))) {
+                score = std::max(score, 0.9);
+                if (trace) Trace::line("[DEBUG] Bonus for greeting keywords");
+            }
+
+            // ĐẶC BIỆT: Nếu là goodbye, cần có "tam biet" hoặc "bye" rõ ràng
+            if (intent.is_goodbye &&
+                !has(PROBE_TAM_BIET) && !has(PROBE_BYE) && !has(PROBE_GOODBYE)) {
+                score *= 0.5;
+            }
+        } else {
+            (void)intent;
+            (void)trace;
+        }
+        return score;
+    };
+
+    // Câu là chuỗi con của pattern đầu tiên chỉ khi mọi byte của câu có trong pattern.
+    // Mặt nạ byte chỉ tính (một lần) khi câu không dài hơn pattern, nên câu dài
+    // (phiên nối thêm liên tục) không phải duyệt lại toàn bộ văn bản
+    uint64_t query_bytes = 0;
+    bool have_query_bytes = false;
+    auto within_first_pattern = [&](const CompiledIntent& intent) {
+        if (s.length > intent.first_pattern.length()) return false;
+        if (!have_query_bytes) {
+            query_bytes = byte_mask(normalized);
+            have_query_bytes = true;
+        }
+        return (query_bytes & ~intent.first_pattern_bytes) == 0;
+    };
+
+    // Chấm một intent, bỏ qua ngay khi cận trên không thắng được best
+    auto score_intent = [&](size_t i) {
+        const auto& intent = model.intents[i];
+        if (!beats(intent.upper_bound, i)) return;
+
+        double score = 0.0;
+        double match_score = 0.0;
+        double similarity_score = 0.0;
+        int keyword_matches = 0;
+        bool may_contain = false;   // bước 4 còn phải tìm chuỗi con
+
+        // 1. EXACT MATCH với patterns (quan trọng nhất)
+        if (exact[i]) {
+            score = 1.0;
+            match_score = 1.0;
+        }
+
+        if (score < 1.0) {
+            // 2. CONTAINS match
+            if constexpr (P::Scorer::contains) {
+                if (s.contains[i] > 0) {
+                    score = 0.8;
+                }
+            }
+
+            // 3. KEYWORDS (cộng theo đúng thứ tự: keyword có bonus đứng trước)
+            keyword_matches = s.keyword_matches[i];
+            for (int k = 0; k < s.keyword_bonus[i]; ++k) {
+                score += 0.3;
+                score += 0.2;  // Bonus cho từ khóa quan trọng
+            }
+            for (int k = s.keyword_bonus[i]; k < keyword_matches; ++k) {
+                score += 0.3;
+            }
+            match_score = score;
+
+            // 4. Độ tương đồng với pattern đầu tiên. Các nhánh tính từ bộ đếm chạy
+            // ngay; tìm chuỗi con (ưu tiên cao nhất) để sau khi xét cận trên
+            if constexpr (P::Scorer::similarity) {
+                if (with_similarity && intent.has_similarity && s.length > 5) {
+                    may_contain = within_first_pattern(intent);
+                    double similarity = 0.0;
+                    if (s.first_pattern_found[i] > 0) {
+                        similarity = 0.8;
+                    } else if (s.common_tokens[i] > 0) {
+                        similarity = static_cast<double>(s.common_tokens[i]) /
+                                     (s.tokens + intent.first_pattern_tokens - s.common_tokens[i]);
+                    }
+                    similarity_score = similarity;
+                    score = std::max(score, similarity);
+                }
+            }
+        }
+
+        score = with_keywords(score, keyword_matches);
+
+        // Cận trên của điểm cuối (tìm chuỗi con thành công thì đạt 1.0 trước luật)
+        if (!beats(apply_rules(intent, may_contain ? 1.0 : score, false), i)) return;
+
+        if (may_contain && intent.first_pattern.find(normalized) != std::string::npos) {
+            double similarity = normalized.length() == intent.first_pattern.length() ? 1.0 : 0.9;
+            similarity_score = similarity;
+            score = with_keywords(std::max(match_score, similarity), keyword_matches);
+        }
+        ++best.scored;
+
+        if (exact[i]) Trace::line("[DEBUG] Exact match found for ", intent.name);
+        Trace::line("[DEBUG] ", intent.name, " score: ", score,
+                    " (threshold: ", intent.threshold, ")");
+
+        score = apply_rules(intent, score, true);
+
+        CaptureRecord::Score captured;
+        if (scores) {
+            CaptureRecord::set_name(captured.intent, intent.name);
+            captured.match = static_cast<float>(match_score);
+            captured.similarity = static_cast<float>(similarity_score);
+            captured.score = static_cast<float>(score);
+            scores->add(static_cast<int>(i), captured);
+        }
+
+        if (beats(score, i) && score >= intent.threshold) {
+            best.confidence = score;
+            best.intent = intent.name;
+            best.index = static_cast<int>(i);
+            best_exact = exact[i];
+            if (scores) scores->set_winner(best.index, captured);
+            Trace::line("[DEBUG] New best intent: ", intent.name, " with score ", score);
+        }
+    };
+
+    // Intent trùng khớp hoàn toàn được chấm trước, nên khi tới các intent còn lại
+    // mà best là trùng khớp thì hòa điểm không còn thắng được
+    for (size_t i : exact_hits) score_intent(i);
+    for (size_t pos = 0; pos < n; ++pos) {
+        // Dừng sớm: cận trên của mọi intent còn lại không thắng được best
+        if (order.exhausted(pos, best.confidence, best_exact ? -1 : best.index)) break;
+        const size_t i = order.indices[pos];
+        if (!exact[i]) score_intent(i);
+    }
+
+    if constexpr (P::Heuristics::enabled) {
+        // Xử lý các trường hợp đặc biệt với heuristic
+        if (best.confidence < 0.4) {
+            Trace::line("[DEBUG] Low score, applying heuristics");
+
+            // Heuristic 1: Nếu có "chao" mà không phải greeting, chuyển thành greeting
+            if (has(PROBE_CHAO) && best.intent != "greeting") {
+                best.intent = "greeting";
+                best.confidence = 0.8;
+                Trace::line("[DEBUG] Heuristic: 'chao' -> greeting");
+            }
+            // Heuristic 2: Nếu có "cam on" mà không phải thank_you
+            else if ((has(PROBE_CAM_ON) || has(PROBE_THANKS)) && best.intent != "thank_you") {
+                best.intent = "thank_you";
+                best.confidence = 0.8;
+                Trace::line("[DEBUG] Heuristic: 'cam on' -> thank_you");
+            }
+            // Heuristic 3: Nếu có "gia" hoặc "tien" mà không phải ask_price
+            else if ((has(PROBE_GIA) || has(PROBE_TIEN) || has(PROBE_BAO_NHIEU)) &&
+                     best.intent != "ask_price") {
+                best.intent = "ask_price";
+                best.confidence = 0.7;
+                Trace::line("[DEBUG] Heuristic: 'gia/tien' -> ask_price");
+            }
+            // Heuristic 4: Nếu có "gio" mà không phải ask_time
+            else if ((has(PROBE_GIO) || has(PROBE_MAY_GIO)) && best.intent != "ask_time") {
+                best.intent = "ask_time";
+                best.confidence = 0.7;
+                Trace::line("[DEBUG] Heuristic: 'gio' -> ask_time");
+            }
+        }
+
+        // ĐẢM BẢO: "xin chao" LUÔN là greeting
+        if (probe_exact[PROBE_XIN_CHAO] || probe_exact[PROBE_CHAO]) {
+            best.intent = "greeting";
+            best.confidence = 1.0;
+            Trace::line("[DEBUG] Force: 'xin chao' -> greeting");
+        }
+
+        // ĐẢM BẢO: "cam on" LUÔN là thank_you
+        if (probe_exact[PROBE_CAM_ON] || probe_exact[PROBE_THANKS]) {
+            best.intent = "thank_you";
+            best.confidence = 1.0;
+            Trace::line("[DEBUG] Force: 'cam on' -> thank_you");
+        }
+    }
+
+    return best;
+}
+
+// Chấm điểm không giảm tải cho phiên và detect_multi (độ phủ đã có trong state)
+template <class P>
+Evaluation evaluate_all(const MatchState<P>& s, const std::string& normalized,
+                        const PrefilterConfig& prefilter, uint32_t& stages) {
+    stages = prefilter.enabled ? STAGE_PREFILTER : 0u;
+    if (out_of_domain(s.coverage, prefilter)) return Evaluation();
+    stages |= P::scoring_stages;
+    return evaluate<P>(s, normalized, s.model->traffic->canonical());
+}
+
+// State so khớp của phiên, ẩn biến thể pipeline sau một giao diện ảo
+class SessionMatch {
+public:
+    virtual ~SessionMatch() = default;
+    virtual void feed_token(const std::string& token) = 0;
+    virtual MatchMark mark() const = 0;
+    virtual void rollback(const MatchMark& mark) = 0;
+    // Chấm điểm bằng evaluate_all của biến thể
+    virtual Evaluation evaluate(const std::string& normalized, const PrefilterConfig& prefilter,
+                                uint32_t& stages) const = 0;
+};
+
+template <class P>
+class PipelineMatch final : public SessionMatch {
+public:
+    explicit PipelineMatch(const CompiledModel& model) : state(model, true) {}
+
+    void feed_token(const std::string& token) override { state.feed_token(token); }
+    MatchMark mark() const override { return state.mark(); }
+    void rollback(const MatchMark& mark) override { state.rollback(mark); }
+
+    Evaluation evaluate(const std::string& normalized, const PrefilterConfig& prefilter,
+                        uint32_t& stages) const override {
+        return evaluate_all<P>(state, normalized, prefilter, stages);
+    }
+
+private:
+    MatchState<P> state;
+};
+
+// Đẩy một mẫu vào capture; không chặn, ring đầy thì bản ghi bị bỏ
+void record_sample(QueryCapture& capture, const std::string& text, const std::string& normalized,
+                   const Evaluation& best, uint32_t stages, bool degraded,
+                   const CaptureScores* scores) {
+    auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    capture.capture([&](CaptureRecord& record) {
+        record.timestamp_us = static_cast<int64_t>(timestamp);
+        record.set_input(text);
+        record.set_normalized(normalized);
+        CaptureRecord::set_name(record.intent, best.intent);
+        record.confidence = static_cast<float>(best.confidence);
+        record.stages = stages;
+        record.degraded = degraded;
+        record.score_count = static_cast<uint8_t>(scores ? scores->copy_to(record.scores) : 0);
+    });
+}
+
+// Entity số đầu tiên thuộc loại type (số lượng, giá, giờ)
+bool find_numeric(const std::string& normalized, NumericType type, std::string& value) {
+    NumericEntity found[8];
+    size_t count = NumberParser::parse(normalized, found, 8);
+    for (size_t i = 0; i < count; ++i) {
+        if (found[i].type == type) {
+            value = NumberParser::format(found[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+// normalized: chuỗi đã qua TextPreprocessor::normalize
+void extract_entities(const std::string& normalized, const std::string& intent,
+                     std::map<std::string, std::string>& entities) {
+    std::string value;
+
+    if (intent == "order_food") {
+        for (const auto& food : FOOD_ITEMS) {
+            std::string food_norm = TextPreprocessor::normalize(food);
+            if (normalized.find(food_norm) != std::string::npos) {
+                entities["food_item"] = food;
+                break;
+            }
+        }
+
+        // Trích xuất số lượng
+        if (find_numeric(normalized, NumericType::NUMBER, value)) {
+            entities["quantity"] = value;
+        }
+
+    } else if (intent == "ask_price") {
+        for (const auto& item : PRICE_ITEMS) {
+            std::string item_norm = TextPreprocessor::normalize(item);
+            if (normalized.find(item_norm) != std::string::npos) {
+                entities["item"] = item;
+                break;
+            }
+        }
+
+        // Giá nêu trong câu ("50k có không", "hai mươi lăm nghìn")
+        if (find_numeric(normalized, NumericType::MONEY, value)) {
+            entities["price"] = value;
+        }
+    } else if (intent == "ask_time") {
+        // Giờ cụ thể ("7 giờ tối", "7h30")
+        if (find_numeric(normalized, NumericType::TIME, value)) {
+            entities["time"] = value;
+        }
+    } else if (intent == "greeting") {
+        // Trích xuất danh xưng
+        std::vector<std::pair<std::string, std::string>> titles = {
+            {"anh", "male"},
+            {"chi", "female"},
+            {"em", "younger"},
+            {"ong", "elder_male"},
+            {"ba", "elder_female"},
+            {"co", "miss"},
+            {"chu", "uncle"}
+        };
+
+        for (const auto& [title, gender] : titles) {
+            if (normalized.find(title) != std::string::npos) {
+                entities["title"] = title;
+                entities["gender"] = gender;
+                break;
+            }
+        }
+    }
+}
+
+}
+
 class IntentDetector::Impl {
 public:
     std::map<std::string, IntentPattern> intent_patterns;
@@ -128,46 +1280,188 @@ public:
         response_patterns["goodbye"] = "Tạm biệt! Hẹn gặp lại bạn!";
     }
 
-    double calculate_similarity(const std::string& text1,
-                                const std::string& text2) {
-        if (text1.empty() || text2.empty()) return 0.0;
-
-        std::string t1 = TextPreprocessor::normalize(text1);
-        std::string t2 = TextPreprocessor::normalize(text2);
 
-        // Nếu hoàn toàn trùng khớp
-        if (t1 == t2) return 1.0;
+    // Biến thể pipeline, cố định từ lúc tạo detector
+    Pipeline pipeline = Pipeline::FULL;
 
-        // Nếu một chuỗi chứa chuỗi kia
-        if (t2.find(t1) != std::string::npos) {
-            return 0.9;
+    // Gọi run với policy của biến thể hiện tại, vd. run(FastPipeline())
+    template <typename Run>
+    auto with_pipeline(Run&& run) {
+        switch (pipeline) {
+            case Pipeline::FAST: return run(FastPipeline());
+            case Pipeline::NO_ENTITIES: return run(NoEntitiesPipeline());
+            case Pipeline::FULL: break;
         }
-        if (t1.find(t2) != std::string::npos) {
-            return 0.8;
+        return run(FullPipeline());
+    }
+
+    // Model đã biên dịch, dựng lại khi có intent mới
+    std::mutex model_mutex;
+    std::shared_ptr<const CompiledModel> compiled;
+    BuildStats build;        // lần dựng gần nhất, giữ bởi model_mutex
+    uint64_t revision = 0;   // tăng mỗi lần intent thay đổi, giữ bởi model_mutex
+
+    // Model và cấu hình prefilter mà một lần nhận dạng dùng. Bản hiện hành được
+    // công bố qua std::atomic_load/store (như capture), nên đường nóng không khóa
+    // model_mutex; nullptr nghĩa là model cần dựng lại.
+    struct Snapshot {
+        std::shared_ptr<const CompiledModel> model;
+        PrefilterConfig prefilter;
+    };
+    std::shared_ptr<const Snapshot> published;
+
+    std::shared_ptr<const Snapshot> snapshot() {
+        auto current = std::atomic_load(&published);
+        if (current) return current;
+        std::lock_guard<std::mutex> lock(model_mutex);
+        if (!compiled) rebuild();
+        return std::atomic_load(&published);
+    }
+
+    std::shared_ptr<const CompiledModel> model() {
+        return snapshot()->model;
+    }
+
+    // Gọi khi giữ model_mutex, sau mỗi lần đổi compiled hoặc prefilter
+    void publish() {
+        std::shared_ptr<const Snapshot> next;
+        if (compiled) next = std::make_shared<const Snapshot>(Snapshot{compiled, prefilter});
+        std::atomic_store(&published, std::move(next));
+    }
+
+    // Biên dịch cho biến thể của detector; không cần giữ model_mutex nếu intent
+    // và response là bản sao
+    std::shared_ptr<const CompiledModel> compile(
+            const std::map<std::string, IntentPattern>& intents,
+            const std::map<std::string, std::string>& responses,
+            ThreadPool* pool, BuildStats& stats) {
+        return with_pipeline([&](auto policy) {
+            return compile_model<decltype(policy)>(intents, responses, pool, stats);
+        });
+    }
+
+    // Gọi khi giữ model_mutex: thay model, giữ lại lượt thắng của model cũ
+    void install(std::shared_ptr<const CompiledModel> model, const BuildStats& stats) {
+        carry_traffic();
+        compiled = std::move(model);
+        seed_traffic(*compiled, carried_hits);
+        build = stats;
+        publish();
+    }
+
+    // Gọi khi giữ model_mutex
+    void rebuild() {
+        auto start = std::chrono::steady_clock::now();
+        BuildStats stats;
+        auto model = compile(intent_patterns, response_patterns, nullptr, stats);
+        stats.total_ms = lap_ms(start);
+        install(std::move(model), stats);
+    }
+
+    // Thứ tự chấm điểm thích nghi. Lượt thắng theo tên intent được giữ lại khi
+    // model dựng lại (add_intent) hoặc nạp từ file thống kê trước khi dựng model.
+    std::atomic<bool> adaptive_order{false};
+    std::map<std::string, uint64_t> carried_hits;   // giữ bởi model_mutex
+
+    void seed_traffic(const CompiledModel& m, const std::map<std::string, uint64_t>& hits) {
+        for (size_t i = 0; i < m.intents.size(); ++i) {
+            auto it = hits.find(m.intents[i].name);
+            if (it != hits.end()) m.traffic->set_hits(i, it->second);
         }
+        m.traffic->reorder();
+    }
 
-        // Tách từ
-        auto tokens1 = TextPreprocessor::tokenize(t1);
-        auto tokens2 = TextPreprocessor::tokenize(t2);
+    // Gọi khi giữ model_mutex, trước khi bỏ model cũ
+    void carry_traffic() {
+        if (!compiled) return;
+        for (size_t i = 0; i < compiled->intents.size(); ++i) {
+            carried_hits[compiled->intents[i].name] = compiled->traffic->hits(i);
+        }
+    }
 
-        if (tokens1.empty() || tokens2.empty()) return 0.0;
+    // Thứ tự cho lần chấm điểm này; holder giữ bản thứ tự thích nghi còn sống
+    const IntentOrder& order(const CompiledModel& m, std::shared_ptr<const IntentOrder>& holder) {
+        if (!adaptive_order.load(std::memory_order_relaxed)) return m.traffic->canonical();
+        holder = m.traffic->current();
+        return *holder;
+    }
 
-        // Tính Jaccard similarity
-        int common_count = 0;
-        for (const auto& t : tokens1) {
-            if (std::find(tokens2.begin(), tokens2.end(), t) != tokens2.end()) {
-                common_count++;
-            }
+    // Thống kê dừng sớm
+    std::atomic<uint64_t> evaluations{0};
+    std::atomic<uint64_t> intents_scored{0};
+    std::atomic<uint64_t> intents_pruned{0};
+
+    void record(const CompiledModel& m, const Evaluation& best) {
+        evaluations.fetch_add(1, std::memory_order_relaxed);
+        intents_scored.fetch_add(best.scored, std::memory_order_relaxed);
+        intents_pruned.fetch_add(m.intents.size() - best.scored, std::memory_order_relaxed);
+        if (best.index >= 0 && adaptive_order.load(std::memory_order_relaxed)) {
+            m.traffic->record(static_cast<size_t>(best.index));
         }
+    }
 
-        if (common_count == 0) return 0.0;
+    // Bộ lọc ngoài miền; giữ bởi model_mutex, detect() đọc qua snapshot()
+    PrefilterConfig prefilter;
+    std::atomic<uint64_t> prefilter_checked{0};
+    std::atomic<uint64_t> prefilter_rejected{0};
 
-        double jaccard = static_cast<double>(common_count) /
-                        (tokens1.size() + tokens2.size() - common_count);
+    PrefilterConfig prefilter_config() {
+        std::lock_guard<std::mutex> lock(model_mutex);
+        return prefilter;
+    }
+
+    bool reject(const CompiledModel& m, const PrefilterConfig& config,
+                const std::string& normalized, Coverage& coverage) {
+        if (!config.enabled) return false;
+        coverage = measure_coverage(m, normalized);
+        prefilter_checked.fetch_add(1, std::memory_order_relaxed);
+        if (!out_of_domain(coverage, config)) return false;
+        prefilter_rejected.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
 
-        return jaccard;
+    // Lấy mẫu truy vấn. Thread nhận dạng giữ shared_ptr tới capture trong lúc
+    // đẩy bản ghi, nên capture đã dừng/bị thay chỉ được giải phóng khi không còn
+    // ai đẩy vào nó. capturing cho phép bỏ qua atomic_load khi không lấy mẫu.
+    std::mutex capture_mutex;
+    std::shared_ptr<QueryCapture> capture;      // đọc/ghi bằng std::atomic_load/store
+    std::atomic<bool> capturing{false};
+    // Capture dừng gần nhất, giữ bởi capture_mutex. Giữ cả đối tượng (không chỉ bản
+    // sao thống kê) vì detect đang chạy dở vẫn có thể tính thêm bản ghi dropped vào nó
+    std::shared_ptr<QueryCapture> stopped;
+
+    // Capture đang chạy nếu câu này được lấy mẫu, ngược lại nullptr
+    std::shared_ptr<QueryCapture> sampled_capture() {
+        if (!capturing.load(std::memory_order_acquire)) return nullptr;
+        auto current = std::atomic_load(&capture);
+        return current && current->sample() ? current : nullptr;
     }
 
+    // Gọi khi giữ capture_mutex: gỡ capture đang chạy, ghi nốt bản ghi và đóng file
+    void retire_capture() {
+        auto previous = std::atomic_exchange(&capture, std::shared_ptr<QueryCapture>());
+        if (!previous) return;
+        previous->stop();
+        stopped = std::move(previous);
+    }
+
+    // Giảm tải
+    std::atomic<LoadLevel> load_level{LoadLevel::NORMAL};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> degraded{0};
+    std::atomic<uint64_t> budget_exceeded{0};
+    std::atomic<uint64_t> similarity_skipped{0};
+    std::atomic<uint64_t> entities_skipped{0};
+
+    template <class P>
+    IntentResult detect(const std::string& text, const DetectOptions& options);
+
+    template <class P>
+    BatchResult detect_batch(const std::vector<std::string>& texts);
+
+    template <class P>
+    std::vector<IntentSpan> detect_multi(const std::string& text);
+
     double calculate_fuzzy_similarity(const std::string& text1,
                                      const std::string& text2) {
         std::string t1 = TextPreprocessor::normalize(text1);
@@ -210,14 +1504,7 @@ public:
         auto tokens = TextPreprocessor::tokenize(text);
         std::vector<std::string> keywords;
 
-        // Stopwords tiếng Việt
-        static const std::vector<std::string> stopwords = {
-            "la", "cua", "va", "co", "duoc", "trong", "toi", "ban",
-            "anh", "chi", "ong", "ba", "nay", "kia", "do", "a", "oi", "mot",
-            "hai", "ba", "bon", "nam", "sau", "bay", "tam", "chin", "muoi",
-            "cai", "con", "nguoi", "no", "nhung", "cac", "hay", "hoac",
-            "nhung", "rat", "qua", "nhieu", "it", "voi", "len", "xuong"
-        };
+        const auto& stopwords = STOPWORDS;
 
         for (const auto& token : tokens) {
             std::string token_lower = token;
@@ -233,76 +1520,6 @@ public:
         return keywords;
     }
 
-    void extract_entities(const std::string& text, const std::string& intent,
-                         std::map<std::string, std::string>& entities) {
-        std::string normalized = TextPreprocessor::normalize(text);
-
-        if (intent == "order_food") {
-            std::vector<std::string> food_items = {
-                "pho", "phở", "bun", "bún", "com", "cơm", "banh", "bánh",
-                "cha", "chả", "nem", "banh mi", "bánh mì", "bun cha", "bún chả",
-                "pho bo", "phở bò", "pho ga", "phở gà", "bun bo", "bún bò",
-                "com tam", "cơm tấm", "banh xeo", "bánh xèo", "goi cuon", "gỏi cuốn",
-                "banh canh", "bánh canh", "hu tieu", "hủ tiếu", "mi", "mì",
-                "banh cuon", "bánh cuốn", "xoi", "xôi", "che", "chè"
-            };
-
-            for (const auto& food : food_items) {
-                std::string food_norm = TextPreprocessor::normalize(food);
-                if (normalized.find(food_norm) != std::string::npos) {
-                    entities["food_item"] = food;
-                    break;
-                }
-            }
-
-            // Trích xuất số lượng
-            std::vector<std::string> numbers = {"1", "2", "3", "4", "5", "6", "7", "8", "9", "10",
-                                               "mot", "hai", "ba", "bon", "nam", "sau", "bay", "tam", "chin", "muoi"};
-            for (const auto& num : numbers) {
-                if (normalized.find(num) != std::string::npos) {
-                    entities["quantity"] = num;
-                    break;
-                }
-            }
-
-        } else if (intent == "ask_price") {
-            std::vector<std::string> items = {
-                "pho", "phở", "bun", "bún", "com", "cơm", "banh", "bánh",
-                "banh mi", "bánh mì", "ca phe", "cà phê", "tra da", "trà đá",
-                "ao", "áo", "quan", "quần", "dien thoai", "điện thoại",
-                "may tinh", "máy tính", "xe may", "xe máy", "oto", "ô tô",
-                "tu lanh", "tủ lạnh", "tivi", "tv", "laptop"
-            };
-
-            for (const auto& item : items) {
-                std::string item_norm = TextPreprocessor::normalize(item);
-                if (normalized.find(item_norm) != std::string::npos) {
-                    entities["item"] = item;
-                    break;
-                }
-            }
-        } else if (intent == "greeting") {
-            // Trích xuất danh xưng
-            std::vector<std::pair<std::string, std::string>> titles = {
-                {"anh", "male"},
-                {"chi", "female"},
-                {"em", "younger"},
-                {"ong", "elder_male"},
-                {"ba", "elder_female"},
-                {"co", "miss"},
-                {"chu", "uncle"}
-            };
-
-            for (const auto& [title, gender] : titles) {
-                if (normalized.find(title) != std::string::npos) {
-                    entities["title"] = title;
-                    entities["gender"] = gender;
-                    break;
-                }
-            }
-        }
-    }
-
     bool check_synonyms(const std::string& word, const std::string& text) {
         if (!synonyms_loaded) {
             load_synonyms();
@@ -327,7 +1544,10 @@ public:
 };
 
 // Constructor
-IntentDetector::IntentDetector() : pimpl(std::make_unique<Impl>()) {
+IntentDetector::IntentDetector() : IntentDetector(Pipeline::FULL) {}
+
+IntentDetector::IntentDetector(Pipeline pipeline) : pimpl(std::make_unique<Impl>()) {
+    pimpl->pipeline = pipeline;
     pimpl->add_default_patterns();
     pimpl->load_synonyms();
 }
@@ -337,194 +1557,480 @@ IntentDetector::~IntentDetector() = default;
 
 // Detect intent
 IntentResult IntentDetector::detect(const std::string& text) {
-    std::string normalized = TextPreprocessor::normalize(text);
-    auto keywords = pimpl->extract_keywords(normalized);
+    return detect(text, DetectOptions());
+}
 
-    // Debug
-    std::cout << "[DEBUG] Input: \"" << text << "\"" << std::endl;
-    std::cout << "[DEBUG] Normalized: \"" << normalized << "\"" << std::endl;
+IntentResult IntentDetector::detect(const std::string& text, const DetectOptions& options) {
+    return pimpl->with_pipeline([&](auto policy) {
+        return pimpl->detect<decltype(policy)>(text, options);
+    });
+}
 
-    double best_score = 0.0;
-    std::string best_intent = "unknown";
-    std::map<std::string, std::string> entities;
+Pipeline IntentDetector::pipeline() const {
+    return pimpl->pipeline;
+}
 
+template <class P>
+IntentResult IntentDetector::Impl::detect(const std::string& text, const DetectOptions& options) {
+    using Trace = typename P::Trace;
+    using Clock = std::chrono::steady_clock;
+    const auto start = options.budget.count() > 0 ? Clock::now() : Clock::time_point();
+    auto over_budget = [&]() {
+        return options.budget.count() > 0 && Clock::now() - start >= options.budget;
+    };
+    const LoadLevel level = this->load_level.load(std::memory_order_relaxed);
+    this->requests.fetch_add(1, std::memory_order_relaxed);
 
-    std::vector<std::string> intent_order = {"greeting", "order_food", "ask_price", "ask_time", "thank_you", "goodbye"};
+    std::string normalized = TextPreprocessor::normalize(text);
+    const auto snapshot = this->snapshot();
+    const auto& model = snapshot->model;
+    const PrefilterConfig& prefilter = snapshot->prefilter;
 
-    for (const auto& intent_name : intent_order) {
-        if (pimpl->intent_patterns.find(intent_name) == pimpl->intent_patterns.end()) {
-            continue;
+    // Debug
+    Trace::line("[DEBUG] Input: \"", text, "\"");
+    Trace::line("[DEBUG] Normalized: \"", normalized, "\"");
+
+    IntentResult result;
+    result.stages = prefilter.enabled ? STAGE_PREFILTER : 0u;
+    auto capture = this->sampled_capture();
+
+    // Câu ngoài miền: trả về "unknown" ngay, không chấm điểm
+    Coverage coverage;
+    if (this->reject(*model, prefilter, normalized, coverage)) {
+        Trace::line("[DEBUG] Out of domain: coverage ", coverage.score());
+        Trace::line("Final result: unknown (0)");
+
+        result.intent = "unknown";
+        result.confidence = 0.0;
+        if (capture) {
+            record_sample(*capture, text, normalized, Evaluation(), result.stages, false,
+                          nullptr);
         }
+        return result;
+    }
 
-        const auto& pattern = pimpl->intent_patterns[intent_name];
-        double score = 0.0;
+    // Một lượt duyệt qua automaton cho mọi pattern/keyword của mọi intent
+    MatchState<P> state(*model);
+    feed_normalized(state, normalized);
+
+    // Giảm tải: exact/contains/keyword luôn chạy, bỏ độ tương đồng rồi đến thực thể
+    // (chỉ tính là giảm tải khi biến thể có chạy bước đó)
+    bool budget_exceeded = false;
+    bool with_similarity = P::Scorer::similarity && level < LoadLevel::CRITICAL;
+    if (with_similarity && over_budget()) {
+        with_similarity = false;
+        budget_exceeded = true;
+    }
+    CaptureScores scores;
+    std::shared_ptr<const IntentOrder> adaptive;
+    Evaluation best = evaluate<P>(state, normalized, this->order(*model, adaptive),
+                                  with_similarity, capture ? &scores : nullptr);
+    this->record(*model, best);
+    result.stages |= P::scoring_stages & ~(with_similarity ? 0u : STAGE_SIMILARITY);
+
+    bool with_entities = P::Entities::enabled && level < LoadLevel::ELEVATED;
+    if (with_entities && over_budget()) {
+        with_entities = false;
+        budget_exceeded = true;
+    }
 
-        // 1. Kiểm tra EXACT MATCH với patterns (quan trọng nhất)
-        for (const auto& pattern_text : pattern.patterns) {
-            std::string normalized_pattern = TextPreprocessor::normalize(pattern_text);
+    // Trích xuất thực thể
+    if (with_entities) {
+        P::Entities::extract(normalized, best.intent, result.entities);
+        result.stages |= STAGE_ENTITIES;
+    }
 
-            if (normalized == normalized_pattern) {
-                score = 1.0;
-                std::cout << "[DEBUG] Exact match found for " << intent_name << std::endl;
-                break;
-            }
-        }
+    result.intent = best.intent;
+    result.confidence = best.confidence;
+    const bool similarity_skipped = P::Scorer::similarity && !with_similarity;
+    const bool entities_skipped = P::Entities::enabled && !with_entities;
+    result.degraded = similarity_skipped || entities_skipped;
+
+    if (result.degraded) {
+        this->degraded.fetch_add(1, std::memory_order_relaxed);
+        if (budget_exceeded) this->budget_exceeded.fetch_add(1, std::memory_order_relaxed);
+        if (similarity_skipped) this->similarity_skipped.fetch_add(1, std::memory_order_relaxed);
+        if (entities_skipped) this->entities_skipped.fetch_add(1, std::memory_order_relaxed);
+        Trace::line("[DEBUG] Degraded: stages 0x", std::hex, result.stages, std::dec);
+    }
 
-        if (score < 1.0) {
-            // 2. Kiểm tra CONTAINS match
-            for (const auto& pattern_text : pattern.patterns) {
-                std::string normalized_pattern = TextPreprocessor::normalize(pattern_text);
-
-                if (normalized.find(normalized_pattern) != std::string::npos &&
-                    normalized_pattern.length() > 2) {  // Chỉ xét pattern dài hơn 2 ký tự
-                    score = std::max(score, 0.8);
-                    std::cout << "[DEBUG] Contains match: \"" << normalized_pattern << "\" in \"" << normalized << "\"" << std::endl;
-                }
-            }
+    auto response = model->responses.find(best.intent);
+    if (response != model->responses.end()) {
+        result.response_pattern = response->second;
+    }
 
-            // 3. Kiểm tra KEYWORDS (quan trọng)
-            int keyword_matches = 0;
-            for (const auto& pattern_keyword : pattern.keywords) {
-                std::string normalized_keyword = TextPreprocessor::normalize(pattern_keyword);
+    if (capture) {
+        record_sample(*capture, text, normalized, best, result.stages, result.degraded,
+                      &scores);
+    }
 
-                // Từ khóa xuất hiện trong câu
-                if (normalized.find(normalized_keyword) != std::string::npos) {
-                    keyword_matches++;
-                    score += 0.3;
+    Trace::line("Final result: ", best.intent, " (", best.confidence, ")");
 
-                    // Ưu tiên đặc biệt cho greeting keywords
-                    if (intent_name == "greeting" &&
-                       (normalized_keyword == "xin" || normalized_keyword == "chao")) {
-                        score += 0.2;  // Bonus cho từ khóa quan trọng
-                    }
-                }
-            }
+    return result;
+}
 
-            // 4. Kiểm tra độ dài pattern (ưu tiên pattern dài hơn)
-            if (!pattern.patterns.empty()) {
-                std::string first_pattern = pattern.patterns[0];
-                if (first_pattern.length() > 5 && normalized.length() > 5) {
-                    double similarity = pimpl->calculate_similarity(normalized, first_pattern);
-                    score = std::max(score, similarity);
-                }
-            }
+BatchResult IntentDetector::detect_batch(const std::vector<std::string>& texts) {
+    return pimpl->with_pipeline([&](auto policy) {
+        return pimpl->detect_batch<Silent<decltype(policy)>>(texts);
+    });
+}
 
-            // Giới hạn điểm số
-            if (score > 1.0) score = 1.0;
+template <class P>
+BatchResult IntentDetector::Impl::detect_batch(const std::vector<std::string>& texts) {
+    const auto snapshot = this->snapshot();
+    const auto& model = snapshot->model;
+    const PrefilterConfig& prefilter = snapshot->prefilter;
+
+    BatchResult batch;
+    batch.intent_ids.reserve(texts.size());
+    batch.confidences.reserve(texts.size());
+    batch.entity_offsets.reserve(texts.size() + 1);
+    batch.entity_offsets.push_back(0);
+    batch.value_offsets.push_back(0);
+
+    // Bảng tên intent cố định theo model: 0 = "unknown"
+    std::unordered_map<std::string, int32_t> intent_ids;
+    auto intent_id = [&](const std::string& name) {
+        auto [it, inserted] = intent_ids.emplace(
+            name, static_cast<int32_t>(batch.intent_names.size()));
+        if (inserted) batch.intent_names.push_back(name);
+        return it->second;
+    };
+    intent_id("unknown");
+    for (const auto& intent : model->intents) {
+        intent_id(intent.name);
+    }
 
-            // Thêm điểm cho số keyword matches
-            if (keyword_matches > 0) {
-                score += keyword_matches * 0.1;
+    std::unordered_map<std::string, int32_t> entity_ids;
+    std::map<std::string, std::string> entities;
+    Coverage coverage;
+
+    std::shared_ptr<const IntentOrder> adaptive;
+    const uint32_t prefilter_stage = prefilter.enabled ? STAGE_PREFILTER : 0u;
+    const uint32_t stages = prefilter_stage | P::scoring_stages |
+                            (P::Entities::enabled ? STAGE_ENTITIES : 0u);
+
+    for (const auto& text : texts) {
+        std::string normalized = TextPreprocessor::normalize(text);
+        auto capture = this->sampled_capture();
+        if (this->reject(*model, prefilter, normalized, coverage)) {
+            batch.intent_ids.push_back(0);
+            batch.confidences.push_back(0.0f);
+            batch.entity_offsets.push_back(static_cast<int64_t>(batch.entity_keys.size()));
+            if (capture) {
+                record_sample(*capture, text, normalized, Evaluation(), prefilter_stage, false,
+                              nullptr);
             }
+            continue;
         }
 
-        // Giới hạn lại
-        if (score > 1.0) score = 1.0;
+        MatchState<P> state(*model);
+        feed_normalized(state, normalized);
+        CaptureScores scores;
+        Evaluation best = evaluate<P>(state, normalized, this->order(*model, adaptive), true,
+                                      capture ? &scores : nullptr);
+        this->record(*model, best);
+        if (capture) record_sample(*capture, text, normalized, best, stages, false, &scores);
+
+        batch.intent_ids.push_back(intent_id(best.intent));
+        batch.confidences.push_back(static_cast<float>(best.confidence));
+
+        entities.clear();
+        P::Entities::extract(normalized, best.intent, entities);
+        for (const auto& [key, value] : entities) {
+            auto [it, inserted] = entity_ids.emplace(
+                key, static_cast<int32_t>(batch.entity_names.size()));
+            if (inserted) batch.entity_names.push_back(key);
+
+            batch.entity_keys.push_back(it->second);
+            batch.value_data += value;
+            batch.value_offsets.push_back(static_cast<int64_t>(batch.value_data.size()));
+        }
+        batch.entity_offsets.push_back(static_cast<int64_t>(batch.entity_keys.size()));
+    }
 
-        std::cout << "[DEBUG] " << intent_name << " score: " << score
-                  << " (threshold: " << pattern.threshold << ")" << std::endl;
+    return batch;
+}
 
-        // ĐẶC BIỆT: Nếu là greeting và có từ "chao" hoặc "xin", ưu tiên cao
-        if (intent_name == "greeting" &&
-           (normalized.find("chao") != std::string::npos ||
-            normalized.find("xin") != std::string::npos ||
-            normalized.find("hello") != std::string::npos ||
-            normalized.find("hi") != std::string::npos)) {
-            score = std::max(score, 0.9);
-            std::cout << "[DEBUG] Bonus for greeting keywords" << std::endl;
-        }
+std::vector<IntentSpan> IntentDetector::detect_multi(const std::string& text) {
+    return pimpl->with_pipeline([&](auto policy) {
+        return pimpl->detect_multi<Silent<decltype(policy)>>(text);
+    });
+}
 
-        // ĐẶC BIỆT: Nếu là goodbye, cần có "tam biet" hoặc "bye" rõ ràng
-        if (intent_name == "goodbye") {
-            if (normalized.find("tam biet") == std::string::npos &&
-                normalized.find("bye") == std::string::npos &&
-                normalized.find("goodbye") == std::string::npos) {
-                score *= 0.5;
-            }
+template <class P>
+std::vector<IntentSpan> IntentDetector::Impl::detect_multi(const std::string& text) {
+    const auto snapshot = this->snapshot();
+    const auto& model = snapshot->model;
+    const PrefilterConfig& prefilter = snapshot->prefilter;
+    Segmentation segmentation = ClauseSegmenter::segment(text);
+
+    // Một state dùng chung: mỗi mệnh đề nạp từ gốc rồi hoàn tác về mốc rỗng
+    MatchState<P> state(*model, true);
+    const auto empty = state.mark();
+    std::string token;
+
+    std::vector<IntentSpan> spans;
+    for (const auto& clause : segmentation.clauses) {
+        for (size_t i = clause.first_token; i < clause.last_token; ++i) {
+            const auto& t = segmentation.tokens[i];
+            token.assign(segmentation.normalized, t.norm_begin, t.norm_end - t.norm_begin);
+            state.feed_token(token);
         }
 
-        if (score > best_score && score >= pattern.threshold) {
-            best_score = score;
-            best_intent = intent_name;
-            std::cout << "[DEBUG] New best intent: " << intent_name << " with score " << score << std::endl;
+        std::string normalized = segmentation.normalized.substr(
+            clause.norm_begin, clause.norm_end - clause.norm_begin);
+        IntentSpan span;
+        Evaluation best = evaluate_all<P>(state, normalized, prefilter, span.stages);
+        state.rollback(empty);
+
+        span.intent = best.intent;
+        span.confidence = best.confidence;
+        if constexpr (P::Entities::enabled) {
+            P::Entities::extract(normalized, best.intent, span.entities);
+            span.stages |= STAGE_ENTITIES;
+        }
+        auto response = model->responses.find(best.intent);
+        if (response != model->responses.end()) {
+            span.response_pattern = response->second;
         }
+        span.begin = clause.begin;
+        span.end = clause.end;
+        span.text = text.substr(clause.begin, clause.end - clause.begin);
+        spans.push_back(std::move(span));
     }
 
-    // Xử lý các trường hợp đặc biệt với heuristic
-    if (best_score < 0.4) {
-        std::cout << "[DEBUG] Low score, applying heuristics" << std::endl;
+    return spans;
+}
+
+std::unique_ptr<DetectionSession> IntentDetector::create_session() {
+    auto impl = pimpl->with_pipeline([&](auto policy) {
+        using P = Silent<decltype(policy)>;
+        auto snapshot = pimpl->snapshot();
+        auto match = std::make_unique<PipelineMatch<P>>(*snapshot->model);
+        return std::make_unique<DetectionSession::Impl>(
+            snapshot->model, snapshot->prefilter, std::move(match), P::Entities::enabled);
+    });
+    return std::unique_ptr<DetectionSession>(new DetectionSession(std::move(impl)));
+}
 
-        // Heuristic 1: Nếu có "chao" mà không phải greeting, chuyển thành greeting
-        if (normalized.find("chao") != std::string::npos && best_intent != "greeting") {
-            best_intent = "greeting";
-            best_score = 0.8;
-            std::cout << "[DEBUG] Heuristic: 'chao' -> greeting" << std::endl;
-        }
-        // Heuristic 2: Nếu có "cam on" mà không phải thank_you
-        else if ((normalized.find("cam on") != std::string::npos ||
-                 normalized.find("thanks") != std::string::npos) &&
-                 best_intent != "thank_you") {
-            best_intent = "thank_you";
-            best_score = 0.8;
-            std::cout << "[DEBUG] Heuristic: 'cam on' -> thank_you" << std::endl;
+void IntentDetector::add_intent(const std::string& intent_name,
+                               const IntentPattern& pattern,
+                               const std::string& response_pattern) {
+    std::lock_guard<std::mutex> lock(pimpl->model_mutex);
+    pimpl->intent_patterns[intent_name] = pattern;
+    if (!response_pattern.empty()) {
+        pimpl->response_patterns[intent_name] = response_pattern;
+    }
+    ++pimpl->revision;
+    pimpl->carry_traffic();
+    pimpl->compiled.reset();
+    pimpl->publish();
+}
+
+BuildStats IntentDetector::add_intents(const std::vector<IntentSpec>& specs, size_t threads) {
+    auto clock = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+
+    // Tách keyword từ patterns (spec không có keyword) song song, rồi ghi theo thứ tự spec
+    std::vector<IntentPattern> patterns(specs.size());
+    pool.parallel_for(specs.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const auto& spec = specs[i];
+            auto& pattern = patterns[i];
+            pattern.patterns = spec.patterns;
+            pattern.keywords = spec.keywords;
+            pattern.threshold = spec.threshold;
+            if (pattern.keywords.empty()) {
+                for (const auto& p : spec.patterns) {
+                    auto tokens = TextPreprocessor::keyword_tokens(p);
+                    pattern.keywords.insert(pattern.keywords.end(), tokens.begin(), tokens.end());
+                }
+            }
         }
-        // Heuristic 3: Nếu có "gia" hoặc "tien" mà không phải ask_price
-        else if ((normalized.find("gia") != std::string::npos ||
-                 normalized.find("tien") != std::string::npos ||
-                 normalized.find("bao nhieu") != std::string::npos) &&
-                 best_intent != "ask_price") {
-            best_intent = "ask_price";
-            best_score = 0.7;
-            std::cout << "[DEBUG] Heuristic: 'gia/tien' -> ask_price" << std::endl;
+    });
+
+    // Ghi intent và chụp bản sao khi giữ khóa; model cũ vẫn phục vụ detect()
+    // trong lúc dựng model mới ngoài khóa
+    std::map<std::string, IntentPattern> intents;
+    std::map<std::string, std::string> responses;
+    uint64_t revision;
+    {
+        std::lock_guard<std::mutex> lock(pimpl->model_mutex);
+        for (size_t i = 0; i < specs.size(); ++i) {
+            pimpl->intent_patterns[specs[i].name] = std::move(patterns[i]);
+            if (!specs[i].response_pattern.empty()) {
+                pimpl->response_patterns[specs[i].name] = specs[i].response_pattern;
+            }
         }
-        // Heuristic 4: Nếu có "gio" mà không phải ask_time
-        else if ((normalized.find("gio") != std::string::npos ||
-                 normalized.find("may gio") != std::string::npos) &&
-                 best_intent != "ask_time") {
-            best_intent = "ask_time";
-            best_score = 0.7;
-            std::cout << "[DEBUG] Heuristic: 'gio' -> ask_time" << std::endl;
+        revision = ++pimpl->revision;
+        intents = pimpl->intent_patterns;
+        responses = pimpl->response_patterns;
+    }
+    double store_ms = lap_ms(clock);
+
+    // Intent đổi trong lúc dựng (add_intent/add_intents khác) thì dựng lại từ bản mới
+    while (true) {
+        BuildStats stats;
+        stats.store_ms = store_ms;
+        auto model = pimpl->compile(intents, responses, &pool, stats);
+
+        std::lock_guard<std::mutex> lock(pimpl->model_mutex);
+        if (pimpl->revision == revision) {
+            stats.total_ms = store_ms + lap_ms(clock);
+            pimpl->install(std::move(model), stats);
+            return stats;
         }
+        revision = pimpl->revision;
+        intents = pimpl->intent_patterns;
+        responses = pimpl->response_patterns;
     }
+}
 
-    // ĐẢM BẢO: "xin chao" LUÔN là greeting
-    if (normalized == "xin chao" || normalized == "chao") {
-        best_intent = "greeting";
-        best_score = 1.0;
-        std::cout << "[DEBUG] Force: 'xin chao' -> greeting" << std::endl;
-    }
+BuildStats IntentDetector::build_stats() const {
+    std::lock_guard<std::mutex> lock(pimpl->model_mutex);
+    return pimpl->build;
+}
 
-    // ĐẢM BẢO: "cam on" LUÔN là thank_you
-    if (normalized == "cam on" || normalized == "thanks") {
-        best_intent = "thank_you";
-        best_score = 1.0;
-        std::cout << "[DEBUG] Force: 'cam on' -> thank_you" << std::endl;
-    }
+void IntentDetector::set_prefilter(const PrefilterConfig& config) {
+    std::lock_guard<std::mutex> lock(pimpl->model_mutex);
+    pimpl->prefilter = config;
+    pimpl->publish();
+}
 
-    // Trích xuất thực thể
-    pimpl->extract_entities(normalized, best_intent, entities);
+PrefilterConfig IntentDetector::prefilter() const {
+    return pimpl->prefilter_config();
+}
 
-    IntentResult result;
-    result.intent = best_intent;
-    result.confidence = best_score;
-    result.entities = entities;
+PrefilterStats IntentDetector::prefilter_stats() const {
+    PrefilterStats stats;
+    stats.checked = pimpl->prefilter_checked.load(std::memory_order_relaxed);
+    stats.rejected = pimpl->prefilter_rejected.load(std::memory_order_relaxed);
+    return stats;
+}
 
-    if (pimpl->response_patterns.find(best_intent) != pimpl->response_patterns.end()) {
-        result.response_pattern = pimpl->response_patterns[best_intent];
-    }
+void IntentDetector::reset_prefilter_stats() {
+    pimpl->prefilter_checked.store(0, std::memory_order_relaxed);
+    pimpl->prefilter_rejected.store(0, std::memory_order_relaxed);
+}
 
-    std::cout << "Final result: " << best_intent << " (" << best_score << ")" << std::endl;
+bool IntentDetector::start_capture(const CaptureConfig& config) {
+    std::lock_guard<std::mutex> lock(pimpl->capture_mutex);
+    auto capture = std::make_shared<QueryCapture>(config);
+    if (!capture->start()) return false;
 
-    return result;
+    pimpl->retire_capture();
+    std::atomic_store(&pimpl->capture, std::move(capture));
+    pimpl->capturing.store(true, std::memory_order_release);
+    return true;
 }
 
-void IntentDetector::add_intent(const std::string& intent_name,
-                               const IntentPattern& pattern,
-                               const std::string& response_pattern) {
-    pimpl->intent_patterns[intent_name] = pattern;
-    if (!response_pattern.empty()) {
-        pimpl->response_patterns[intent_name] = response_pattern;
+void IntentDetector::stop_capture() {
+    std::lock_guard<std::mutex> lock(pimpl->capture_mutex);
+    pimpl->capturing.store(false, std::memory_order_release);
+    pimpl->retire_capture();
+}
+
+CaptureStats IntentDetector::capture_stats() const {
+    std::lock_guard<std::mutex> lock(pimpl->capture_mutex);
+    auto current = std::atomic_load(&pimpl->capture);
+    if (current) return current->stats();
+    return pimpl->stopped ? pimpl->stopped->stats() : CaptureStats();
+}
+
+void IntentDetector::set_load_level(LoadLevel level) {
+    pimpl->load_level.store(level, std::memory_order_relaxed);
+}
+
+LoadLevel IntentDetector::load_level() const {
+    return pimpl->load_level.load(std::memory_order_relaxed);
+}
+
+DegradationStats IntentDetector::degradation_stats() const {
+    DegradationStats stats;
+    stats.requests = pimpl->requests.load(std::memory_order_relaxed);
+    stats.degraded = pimpl->degraded.load(std::memory_order_relaxed);
+    stats.budget_exceeded = pimpl->budget_exceeded.load(std::memory_order_relaxed);
+    stats.similarity_skipped = pimpl->similarity_skipped.load(std::memory_order_relaxed);
+    stats.entities_skipped = pimpl->entities_skipped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void IntentDetector::reset_degradation_stats() {
+    pimpl->requests.store(0, std::memory_order_relaxed);
+    pimpl->degraded.store(0, std::memory_order_relaxed);
+    pimpl->budget_exceeded.store(0, std::memory_order_relaxed);
+    pimpl->similarity_skipped.store(0, std::memory_order_relaxed);
+    pimpl->entities_skipped.store(0, std::memory_order_relaxed);
+}
+
+void IntentDetector::set_adaptive_order(bool enabled) {
+    pimpl->adaptive_order.store(enabled, std::memory_order_relaxed);
+}
+
+bool IntentDetector::adaptive_order() const {
+    return pimpl->adaptive_order.load(std::memory_order_relaxed);
+}
+
+std::vector<std::string> IntentDetector::evaluation_order() {
+    auto model = pimpl->model();
+    std::shared_ptr<const IntentOrder> adaptive;
+    const IntentOrder& order = pimpl->order(*model, adaptive);
+
+    std::vector<std::string> names;
+    for (uint32_t index : order.indices) {
+        names.push_back(model->intents[index].name);
+    }
+    return names;
+}
+
+// Mỗi dòng: tên intent <tab> số lượt thắng
+bool IntentDetector::save_order_stats(const std::string& filepath) {
+    auto model = pimpl->model();
+    std::ofstream file(filepath);
+    if (!file) return false;
+    for (size_t i = 0; i < model->intents.size(); ++i) {
+        file << model->intents[i].name << '\t' << model->traffic->hits(i) << '\n';
+    }
+    return static_cast<bool>(file);
+}
+
+bool IntentDetector::load_order_stats(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file) return false;
+
+    std::map<std::string, uint64_t> hits;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        try {
+            hits[line.substr(0, tab)] = std::stoull(line.substr(tab + 1));
+        } catch (const std::exception&) {
+            return false;
+        }
     }
+
+    std::lock_guard<std::mutex> lock(pimpl->model_mutex);
+    for (const auto& [name, count] : hits) {
+        pimpl->carried_hits[name] = count;
+    }
+    if (pimpl->compiled) pimpl->seed_traffic(*pimpl->compiled, hits);
+    return true;
+}
+
+EvaluationStats IntentDetector::evaluation_stats() const {
+    EvaluationStats stats;
+    stats.evaluations = pimpl->evaluations.load(std::memory_order_relaxed);
+    stats.intents_scored = pimpl->intents_scored.load(std::memory_order_relaxed);
+    stats.intents_pruned = pimpl->intents_pruned.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void IntentDetector::reset_evaluation_stats() {
+    pimpl->evaluations.store(0, std::memory_order_relaxed);
+    pimpl->intents_scored.store(0, std::memory_order_relaxed);
+    pimpl->intents_pruned.store(0, std::memory_order_relaxed);
 }
 
 bool IntentDetector::load_from_json(const std::string& filepath) {
@@ -534,4 +2040,146 @@ bool IntentDetector::load_from_json(const std::string& filepath) {
     return true;
 }
 
+// ---------------------------------------------------------------------------
+// DetectionSession
+// ---------------------------------------------------------------------------
+
+class DetectionSession::Impl {
+public:
+    Impl(std::shared_ptr<const CompiledModel> m, const PrefilterConfig& filter,
+         std::unique_ptr<SessionMatch> match, bool entities)
+        : model(std::move(m)), prefilter(filter), with_entities(entities),
+          state(std::move(match)) {
+        refresh();
+    }
+
+    // Mỗi token đã chốt (có khoảng trắng phía sau) giữ một mốc để hoàn tác
+    struct Checkpoint {
+        size_t raw_begin;       // vị trí bắt đầu token trong raw
+        size_t raw_end;         // vị trí khoảng trắng kết thúc token
+        size_t normalized_size;
+        MatchMark mark;
+    };
+
+    std::shared_ptr<const CompiledModel> model;
+    PrefilterConfig prefilter;
+    bool with_entities;
+    std::unique_ptr<SessionMatch> state;
+
+    std::string raw;
+    size_t committed = 0;       // raw[0, committed) đã được nạp vào state
+    std::string normalized;     // văn bản chuẩn hóa của phần đã chốt
+    std::vector<Checkpoint> checkpoints;
+
+    std::string tail;           // token cuối (chưa chốt) đã chuẩn hóa
+    IntentResult current;
+
+    static bool is_space(char c) {
+        return std::isspace(static_cast<unsigned char>(c)) != 0;
+    }
+
+    // Chốt các token đã hoàn chỉnh trong raw[committed, ...)
+    void advance() {
+        size_t pos = committed;
+        while (true) {
+            while (pos < raw.size() && is_space(raw[pos])) ++pos;
+            size_t end = pos;
+            while (end < raw.size() && !is_space(raw[end])) ++end;
+            if (end == raw.size()) break;  // token cuối có thể còn thay đổi
+
+            std::string token = TextPreprocessor::normalize(raw.substr(pos, end - pos));
+            checkpoints.push_back({pos, end, normalized.size(), state->mark()});
+            if (!token.empty()) {
+                if (!normalized.empty()) normalized += ' ';
+                normalized += token;
+                state->feed_token(token);
+            }
+            pos = end;
+        }
+        committed = pos;
+        tail = TextPreprocessor::normalize(raw.substr(pos));
+    }
+
+    // Hoàn tác các token có khoảng trắng kết thúc nằm từ vị trí keep trở đi
+    void truncate(size_t keep) {
+        while (!checkpoints.empty() && checkpoints.back().raw_end >= keep) {
+            const auto& cp = checkpoints.back();
+            state->rollback(cp.mark);
+            normalized.resize(cp.normalized_size);
+            committed = cp.raw_begin;
+            checkpoints.pop_back();
+        }
+        committed = std::min(committed, keep);
+        raw.resize(keep);
+    }
+
+    // Tính lại kết quả: nạp tạm token cuối, chấm điểm rồi hoàn tác
+    void refresh() {
+        auto mark = state->mark();
+        size_t normalized_size = normalized.size();
+        if (!tail.empty()) {
+            if (!normalized.empty()) normalized += ' ';
+            normalized += tail;
+            state->feed_token(tail);
+        }
+
+        Evaluation best = state->evaluate(normalized, prefilter, current.stages);
+        current.intent = best.intent;
+        current.confidence = best.confidence;
+        current.entities.clear();
+        auto response = model->responses.find(best.intent);
+        current.response_pattern =
+            response != model->responses.end() ? response->second : std::string();
+
+        state->rollback(mark);
+        normalized.resize(normalized_size);
+    }
+
+    std::string full_normalized() const {
+        if (tail.empty()) return normalized;
+        if (normalized.empty()) return tail;
+        return normalized + ' ' + tail;
+    }
+};
+
+DetectionSession::DetectionSession(std::unique_ptr<Impl> impl) : pimpl(std::move(impl)) {}
+
+DetectionSession::~DetectionSession() = default;
+
+const IntentResult& DetectionSession::append(const std::string& chunk) {
+    pimpl->raw += chunk;
+    pimpl->advance();
+    pimpl->refresh();
+    return pimpl->current;
+}
+
+const IntentResult& DetectionSession::revise(size_t erase_bytes, const std::string& replacement) {
+    size_t keep = erase_bytes >= pimpl->raw.size() ? 0 : pimpl->raw.size() - erase_bytes;
+    pimpl->truncate(keep);
+    return append(replacement);
+}
+
+void DetectionSession::reset() {
+    pimpl->truncate(0);
+    pimpl->advance();
+    pimpl->refresh();
+}
+
+const IntentResult& DetectionSession::current() const {
+    return pimpl->current;
+}
+
+IntentResult DetectionSession::result() const {
+    IntentResult result = pimpl->current;
+    if (pimpl->with_entities) {
+        extract_entities(pimpl->full_normalized(), result.intent, result.entities);
+        result.stages |= STAGE_ENTITIES;
+    }
+    return result;
+}
+
+const std::string& DetectionSession::text() const {
+    return pimpl->raw;
+}
+
 }
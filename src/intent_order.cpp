@@ -0,0 +1,74 @@
+#include "intent_order.h"
+#include <algorithm>
+#include <numeric>
+
+namespace VietIntent {
+
+IntentOrder::IntentOrder(std::vector<uint32_t> order, const std::vector<double>& upper_bounds)
+    : indices(std::move(order)),
+      suffix_bound(indices.size() + 1),
+      suffix_first(indices.size() + 1) {
+    // Vị trí cuối là phần rỗng: không intent nào thắng được
+    suffix_bound.back() = -1.0;
+    suffix_first.back() = UINT32_MAX;
+    for (size_t k = indices.size(); k-- > 0;) {
+        suffix_bound[k] = std::max(suffix_bound[k + 1], upper_bounds[indices[k]]);
+        suffix_first[k] = std::min(suffix_first[k + 1], indices[k]);
+    }
+}
+
+AdaptiveOrder::AdaptiveOrder(std::vector<double> upper_bounds, uint64_t reorder_interval)
+    : bounds(std::move(upper_bounds)),
+      interval(std::max<uint64_t>(reorder_interval, 1)),
+      counts(new std::atomic<uint64_t>[bounds.size()]) {
+    std::vector<uint32_t> identity(bounds.size());
+    std::iota(identity.begin(), identity.end(), 0u);
+    initial = std::make_shared<const IntentOrder>(std::move(identity), bounds);
+    order = initial;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::shared_ptr<const IntentOrder> AdaptiveOrder::current() const {
+    return std::atomic_load_explicit(&order, std::memory_order_acquire);
+}
+
+void AdaptiveOrder::record(size_t index) {
+    if (index >= bounds.size()) return;
+    counts[index].fetch_add(1, std::memory_order_relaxed);
+    if ((recorded.fetch_add(1, std::memory_order_relaxed) + 1) % interval == 0) {
+        reorder();
+    }
+}
+
+uint64_t AdaptiveOrder::hits(size_t index) const {
+    return counts[index].load(std::memory_order_relaxed);
+}
+
+void AdaptiveOrder::set_hits(size_t index, uint64_t count) {
+    if (index < bounds.size()) counts[index].store(count, std::memory_order_relaxed);
+}
+
+void AdaptiveOrder::reorder() {
+    // Một thread sắp lại là đủ; thread khác bỏ qua thay vì chờ
+    std::unique_lock<std::mutex> lock(reorder_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+
+    std::vector<uint64_t> snapshot(bounds.size());
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        snapshot[i] = counts[i].load(std::memory_order_relaxed);
+    }
+    std::vector<uint32_t> ranked(bounds.size());
+    std::iota(ranked.begin(), ranked.end(), 0u);
+    std::stable_sort(ranked.begin(), ranked.end(), [&](uint32_t a, uint32_t b) {
+        return snapshot[a] > snapshot[b];
+    });
+
+    if (ranked == current()->indices) return;
+    std::atomic_store_explicit(&order,
+                               std::make_shared<const IntentOrder>(std::move(ranked), bounds),
+                               std::memory_order_release);
+}
+
+}
@@ -0,0 +1,562 @@
+#include "number_parser.h"
+#include <cmath>
+#include <cstdio>
+#include <string_view>
+
+namespace VietIntent {
+
+namespace {
+
+struct Token {
+    std::string_view text;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// Duyệt token của chuỗi đã chuẩn hóa (phân cách bởi khoảng trắng), không cấp phát
+class Cursor {
+public:
+    explicit Cursor(std::string_view s) : text(s) { load(0); }
+
+    const Token& peek() const { return token; }
+    bool done() const { return token.text.empty(); }
+    void next() { load(token.end); }
+
+    std::string_view peek_next() const {
+        Cursor c = *this;
+        c.next();
+        return c.peek().text;
+    }
+
+private:
+    void load(size_t pos) {
+        while (pos < text.size() && text[pos] == ' ') ++pos;
+        size_t end = pos;
+        while (end < text.size() && text[end] != ' ') ++end;
+        token = {text.substr(pos, end - pos), pos, end};
+    }
+
+    std::string_view text;
+    Token token;
+};
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+bool is_letter(char c) { return c >= 'a' && c <= 'z'; }
+
+double pow10(size_t n) {
+    double p = 1;
+    while (n-- > 0) p *= 10;
+    return p;
+}
+
+// Chữ số đọc bằng chữ (đã bỏ dấu); -1 nếu không phải
+int unit_value(std::string_view w) {
+    if (w == "khong") return 0;
+    if (w == "mot") return 1;
+    if (w == "hai") return 2;
+    if (w == "ba") return 3;
+    if (w == "bon" || w == "tu") return 4;
+    if (w == "nam" || w == "lam" || w == "nham") return 5;
+    if (w == "sau") return 6;
+    if (w == "bay") return 7;
+    if (w == "tam") return 8;
+    if (w == "chin") return 9;
+    return -1;
+}
+
+// "lăm", "nhăm", "tư" chỉ đứng sau "mươi" (hai mươi lăm) hoặc rút gọn (hai triệu tư)
+bool is_trailing_unit(std::string_view w) {
+    return w == "lam" || w == "nham" || w == "tu";
+}
+
+double magnitude(std::string_view w) {
+    if (w == "nghin" || w == "ngan" || w == "k") return 1e3;
+    if (w == "trieu" || w == "tr" || w == "cu") return 1e6;
+    if (w == "ty" || w == "ti") return 1e9;
+    return 0;
+}
+
+bool is_currency(std::string_view w) {
+    return w == "dong" || w == "d" || w == "vnd";
+}
+
+bool is_hour_word(std::string_view w) {
+    return w == "h" || w == "g" || w == "gio";
+}
+
+bool is_minute_word(std::string_view w) {
+    return w == "phut" || w == "p";
+}
+
+bool is_hour(double v) {
+    return v >= 0 && v <= 24 && v == std::floor(v);
+}
+
+// Từ số đứng một mình nhưng thực ra là từ khác: "tạm biệt", "sau khi", "chào bà",
+// tên món "cơm tấm", "phở bò chín", "chè ba màu"...
+bool is_collocation(std::string_view prev, std::string_view word, std::string_view next) {
+    static const std::string_view before[][2] = {
+        {"tam", "biet"}, {"sau", "khi"}, {"sau", "do"}, {"sau", "nay"},
+        {"nam", "nay"}, {"nam", "ngoai"}, {"nam", "sau"}, {"nam", "truoc"},
+        {"nam", "moi"}, {"ba", "oi"}, {"mot", "chut"}, {"mot", "it"},
+        {"mot", "so"}, {"mot", "lat"}, {"bay", "gio"},
+        {"ba", "chi"}, {"ba", "mau"}, {"hai", "san"}, {"nam", "vang"}
+    };
+    static const std::string_view after[][2] = {
+        {"com", "tam"}, {"bo", "chin"}, {"tai", "chin"}, {"may", "bay"}
+    };
+    for (const auto& pair : before) {
+        if (word == pair[0] && next == pair[1]) return true;
+    }
+    for (const auto& pair : after) {
+        if (prev == pair[0] && word == pair[1]) return true;
+    }
+    // "năm 2024": năm (year) đứng trước số năm
+    if (word == "nam" && !next.empty() && is_digit(next[0])) return true;
+    return prev == "chao" || prev == "thua" || prev == "ong";
+}
+
+// Từ chỉ đơn vị/lượng từ đứng sau số đếm: "tám ly", "tám người"
+bool is_counter(std::string_view w) {
+    static const std::string_view words[] = {
+        "ly", "coc", "to", "bat", "dia", "phan", "suat", "cai", "chiec", "hop", "chai",
+        "lon", "goi", "mieng", "xien", "nguoi", "ban", "con", "qua", "trai", "kg", "lang",
+        "lan", "ngay", "tuan", "thang", "nam", "phut", "tieng", "cuon", "doi", "bo", "cap"
+    };
+    for (const auto& word : words) {
+        if (w == word) return true;
+    }
+    return false;
+}
+
+// "tam" là "tám", "tạm" hoặc "tấm" sau khi bỏ dấu ("ăn tạm", "tấm ảnh"):
+// đứng một mình chỉ đọc là 8 khi có lượng từ phía sau
+bool is_ambiguous_unit(std::string_view word, std::string_view next) {
+    return word == "tam" && !is_counter(next);
+}
+
+// Token bắt đầu bằng chữ số: "50", "1.500.000", "1,5", "7:30", "50k", "2tr5", "7h30p"
+struct DigitToken {
+    double value = 0;
+    int minutes = -1;           // "7:30" -> 30
+    std::string_view suffix;    // chữ ngay sau số: "k", "tr", "h"
+    int trailing = -1;          // chữ số sau suffix: "2tr5" -> 5
+    size_t trailing_digits = 0;
+    std::string_view tail;      // chữ sau trailing: "7h30p" -> "p"
+    bool grouped = false;       // số nguyên có phân cách hàng nghìn: "1.500.000"
+
+    bool plain() const { return minutes < 0 && suffix.empty(); }
+};
+
+bool parse_digit_token(std::string_view t, DigitToken& d) {
+    d = DigitToken();
+    const size_t n = t.size();
+    if (n == 0 || !is_digit(t[0])) return false;
+
+    // Phần số: "." và "," là phân cách hàng nghìn nếu mọi nhóm sau đó đủ 3 chữ số,
+    // ngược lại (chỉ một dấu) là dấu thập phân. Dấu cuối khác loại các dấu trước
+    // là dấu thập phân sau phần hàng nghìn: "1.000,5", "1,000.5"
+    size_t i = 0;
+    double whole = 0, head = 0, before_last = 0;
+    size_t seps = 0, group_len = 0, first_group = 0;
+    bool thousands = true;
+    char first_sep = 0, last_sep = 0;
+    bool same_before_last = true;   // các dấu trước dấu cuối cùng loại first_sep
+    while (i < n) {
+        if (is_digit(t[i])) {
+            whole = whole * 10 + (t[i] - '0');
+            ++group_len;
+            ++i;
+        } else if ((t[i] == '.' || t[i] == ',') && i + 1 < n && is_digit(t[i + 1])) {
+            if (seps == 0) {
+                head = whole;
+                first_group = group_len;
+                first_sep = t[i];
+            } else {
+                if (group_len != 3) thousands = false;
+                if (last_sep != first_sep) same_before_last = false;
+            }
+            before_last = whole;
+            last_sep = t[i];
+            ++seps;
+            group_len = 0;
+            ++i;
+        } else {
+            break;
+        }
+    }
+
+    const bool mixed = seps >= 2 && same_before_last && last_sep != first_sep;
+    if (seps == 0) {
+        d.value = whole;
+    } else if (group_len == 3 && thousands && first_group <= 3 && !mixed &&
+               same_before_last) {
+        d.value = whole;
+        d.grouped = true;
+    } else if (seps == 1) {
+        double scale = pow10(group_len);
+        d.value = head + (whole - head * scale) / scale;
+    } else if (mixed && thousands && first_group <= 3) {
+        double scale = pow10(group_len);
+        d.value = before_last + (whole - before_last * scale) / scale;
+    } else {
+        return false;
+    }
+
+    if (i < n && t[i] == ':') {
+        int minutes = 0;
+        size_t digits = 0;
+        for (++i; i < n && is_digit(t[i]) && digits < 2; ++i, ++digits) {
+            minutes = minutes * 10 + (t[i] - '0');
+        }
+        if (digits == 0) return false;
+        d.minutes = minutes;
+        return i == n;
+    }
+
+    size_t start = i;
+    while (i < n && is_letter(t[i])) ++i;
+    d.suffix = t.substr(start, i - start);
+
+    if (!d.suffix.empty() && i < n && is_digit(t[i])) {
+        d.trailing = 0;
+        while (i < n && is_digit(t[i])) {
+            if (++d.trailing_digits > 3) return false;
+            d.trailing = d.trailing * 10 + (t[i] - '0');
+            ++i;
+        }
+        start = i;
+        while (i < n && is_letter(t[i])) ++i;
+        d.tail = t.substr(start, i - start);
+    }
+
+    return i == n;
+}
+
+// Cụm số: chữ số và/hoặc số đọc bằng chữ với mươi/trăm/linh/nghìn/triệu/tỷ/rưỡi
+struct Phrase {
+    double value = 0;
+    size_t begin = 0;
+    size_t end = 0;
+    int words = 0;
+    bool spelled = true;    // toàn bộ đọc bằng chữ
+    bool money = false;     // có nghìn/triệu/tỷ
+    bool half = false;      // kết thúc bằng "rưỡi"
+    bool grouped = false;   // một token số có phân cách hàng nghìn
+};
+
+bool parse_phrase(Cursor& cur, Phrase& p) {
+    p = Phrase();
+
+    double total = 0;       // phần đã nhân nghìn/triệu/tỷ
+    double group = 0;       // nhóm dưới 1000 đang dựng
+    double pending = 0;     // chữ số chờ mươi/trăm/nghìn
+    double scale = 0;       // trăm/nghìn/triệu/tỷ gần nhất
+    bool has_pending = false;
+    bool abbrev = false;    // chữ số đứng ngay sau scale: "hai triệu tư" = 2.400.000
+    bool tens = false, units = false, hundreds = false, linh = false;
+    bool after_scale = false;
+
+    while (!cur.done()) {
+        const Token& t = cur.peek();
+        const std::string_view w = t.text;
+        const bool first = p.words == 0;
+        bool scale_word = false;
+
+        DigitToken d;
+        int u = unit_value(w);
+        double m = magnitude(w);
+
+        if (parse_digit_token(w, d) && d.plain()) {
+            if ((!first && !after_scale) || has_pending) break;
+            pending = d.value;
+            has_pending = true;
+            abbrev = after_scale && d.value < 10 && d.value == std::floor(d.value);
+            p.spelled = false;
+            p.grouped = first && d.grouped;
+        } else if (u >= 0) {
+            if (has_pending) break;
+            if (tens && !units) {
+                group += u;
+                units = true;
+            } else if (linh) {
+                group += u;
+                linh = false;
+                units = true;
+            } else if (tens || units) {
+                break;
+            } else {
+                if (is_trailing_unit(w) && !(after_scale && w == "tu")) break;
+                // "không" thường là phủ định, chỉ nhận "không trăm"
+                if (u == 0 && cur.peek_next() != "tram") break;
+                pending = u;
+                has_pending = true;
+                abbrev = after_scale;
+            }
+        } else if (w == "muoi") {
+            if (tens || units || linh) break;
+            group += has_pending ? pending * 10 : 10;   // "mười" = 10, "hai mươi" = 20
+            has_pending = false;
+            abbrev = false;
+            tens = true;
+        } else if (w == "tram") {
+            if (!has_pending || hundreds || tens || units) break;
+            group += pending * 100;
+            has_pending = false;
+            abbrev = false;
+            hundreds = true;
+            scale = 100;
+            scale_word = true;
+        } else if (w == "linh" || w == "le") {
+            if (!after_scale || has_pending) break;
+            linh = true;
+        } else if (m > 0) {
+            double v = group + (has_pending ? pending : 0);
+            if (first || v == 0) break;
+            total += v * m;
+            group = 0;
+            has_pending = false;
+            abbrev = false;
+            tens = units = hundreds = linh = false;
+            scale = m;
+            scale_word = true;
+            p.money = true;
+        } else if (w == "ruoi") {
+            if (first) break;
+            if (after_scale) {
+                if (scale == 100) group += 50;
+                else total += scale / 2;
+            } else if (has_pending) {
+                pending += 0.5;
+            } else {
+                group += 0.5;
+            }
+            p.half = true;
+            p.end = t.end;
+            ++p.words;
+            cur.next();
+            break;
+        } else {
+            break;
+        }
+
+        if (first) p.begin = t.begin;
+        p.end = t.end;
+        ++p.words;
+        after_scale = scale_word;
+        cur.next();
+    }
+
+    if (p.words == 0) return false;
+
+    if (has_pending) {
+        group += (abbrev && scale >= 100) ? pending * scale / 10 : pending;
+    }
+    p.value = total + group;
+    return true;
+}
+
+struct TimeValue {
+    int hour = 0;
+    int minute = 0;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+// Số phút sau "giờ"/"kém": "30", "30 phút", "30p", "mười lăm", "năm phút"
+bool parse_minutes(Cursor& cur, int& minutes, size_t& end) {
+    Cursor c = cur;
+    const Token t = c.peek();
+    DigitToken d;
+
+    if (parse_digit_token(t.text, d) && d.minutes < 0 && d.trailing < 0 &&
+        (d.suffix.empty() || is_minute_word(d.suffix))) {
+        if (d.value > 59 || d.value != std::floor(d.value)) return false;
+        minutes = static_cast<int>(d.value);
+        end = t.end;
+        c.next();
+    } else {
+        Phrase p;
+        if (!parse_phrase(c, p) || !p.spelled || p.money || p.half) return false;
+        if (p.value > 59 || p.value != std::floor(p.value)) return false;
+        // Tránh nuốt số đếm phía sau ("7 giờ một người"): cần "phút" hoặc có "mươi"
+        if (!is_minute_word(c.peek().text) && p.words < 2 && t.text != "muoi") return false;
+        minutes = static_cast<int>(p.value);
+        end = p.end;
+    }
+
+    if (is_minute_word(c.peek().text)) {
+        end = c.peek().end;
+        c.next();
+    }
+    cur = c;
+    return true;
+}
+
+// Buổi trong ngày sau giờ: sáng, trưa, chiều, tối, đêm, khuya
+bool parse_daypart(Cursor& cur, TimeValue& tm) {
+    const std::string_view w = cur.peek().text;
+    if (w == "sang") {
+        if (tm.hour == 12) tm.hour = 0;
+    } else if (w == "trua") {
+        if (tm.hour < 5) tm.hour += 12;
+    } else if (w == "chieu" || w == "toi") {
+        if (tm.hour < 12) tm.hour += 12;
+    } else if (w == "dem" || w == "khuya") {
+        if (tm.hour >= 6 && tm.hour < 12) tm.hour += 12;
+        else if (tm.hour == 12) tm.hour = 0;
+    } else {
+        return false;
+    }
+    tm.end = cur.peek().end;
+    cur.next();
+    return true;
+}
+
+// Phần sau "giờ": phút, "rưỡi", "kém N", rồi buổi; trả về true nếu có đọc thêm
+bool parse_time_tail(Cursor& cur, TimeValue& tm) {
+    bool detail = false;
+    const std::string_view w = cur.peek().text;
+    int minutes = 0;
+    size_t end = 0;
+
+    if (w == "ruoi") {
+        tm.minute = 30;
+        tm.end = cur.peek().end;
+        cur.next();
+        detail = true;
+    } else if (w == "kem") {
+        Cursor c = cur;
+        c.next();
+        if (parse_minutes(c, minutes, end) && minutes > 0) {
+            tm.hour = (tm.hour + 23) % 24;
+            tm.minute = 60 - minutes;
+            tm.end = end;
+            cur = c;
+            detail = true;
+        }
+    } else if (parse_minutes(cur, minutes, end)) {
+        tm.minute = minutes;
+        tm.end = end;
+        detail = true;
+    }
+
+    if (parse_daypart(cur, tm)) detail = true;
+    return detail;
+}
+
+}
+
+size_t NumberParser::parse(const std::string& normalized, NumericEntity* out, size_t capacity) {
+    Cursor cur(normalized);
+    size_t count = 0;
+    std::string_view prev;
+
+    auto emit = [&](NumericType type, double value, size_t begin, size_t end) {
+        out[count++] = {type, value, begin, end};
+    };
+    auto emit_time = [&](TimeValue tm) {
+        emit(NumericType::TIME, (tm.hour % 24) * 60 + tm.minute, tm.begin, tm.end);
+    };
+
+    while (!cur.done() && count < capacity) {
+        const Token t = cur.peek();
+        DigitToken d;
+
+        // Token tự đủ nghĩa: "7:30", "7h30", "50k", "2tr5", "30.000d"
+        if (parse_digit_token(t.text, d) && !d.plain()) {
+            cur.next();
+            if (d.minutes >= 0 || is_hour_word(d.suffix)) {
+                int minute = d.minutes >= 0 ? d.minutes : (d.trailing >= 0 ? d.trailing : 0);
+                if (is_hour(d.value) && minute <= 59 &&
+                    (d.tail.empty() || is_minute_word(d.tail))) {
+                    TimeValue tm{static_cast<int>(d.value), minute, t.begin, t.end};
+                    if (d.minutes < 0 && d.trailing < 0) parse_time_tail(cur, tm);
+                    else parse_daypart(cur, tm);
+                    emit_time(tm);
+                }
+            } else if (double m = magnitude(d.suffix); m > 0 && d.tail.empty()) {
+                double value = d.value;
+                if (d.trailing >= 0) value += d.trailing / pow10(d.trailing_digits);
+                size_t end = t.end;
+                if (is_currency(cur.peek().text)) {
+                    end = cur.peek().end;
+                    cur.next();
+                }
+                emit(NumericType::MONEY, value * m, t.begin, end);
+            } else if (is_currency(d.suffix) && d.trailing < 0) {
+                emit(NumericType::MONEY, d.value, t.begin, t.end);
+            }
+            prev = std::string_view();
+            continue;
+        }
+
+        Cursor start = cur;
+        Phrase p;
+        if (!parse_phrase(cur, p)) {
+            prev = t.text;
+            cur.next();
+            continue;
+        }
+
+        const Token next = cur.peek();
+        const bool single_word = p.spelled && p.words == 1;
+
+        if (next.text == "gio" && !p.half && is_hour(p.value)) {
+            cur.next();
+            TimeValue tm{static_cast<int>(p.value), 0, p.begin, next.end};
+            bool detail = parse_time_tail(cur, tm);
+            // "bây giờ" (bây giờ = now) trùng chữ với "bảy giờ" khi đã bỏ dấu
+            if (!(single_word && t.text == "bay" && !detail)) {
+                emit_time(tm);
+            }
+        } else if (p.money || is_currency(next.text) || (p.grouped && p.words == 1)) {
+            // Số viết có phân cách hàng nghìn ("giá 1.500.000") là tiền
+            size_t end = p.end;
+            if (is_currency(next.text)) {
+                end = next.end;
+                cur.next();
+            }
+            emit(NumericType::MONEY, p.value, p.begin, end);
+        } else if (single_word && (is_collocation(prev, t.text, next.text) ||
+                                   is_ambiguous_unit(t.text, next.text))) {
+            cur = start;
+            cur.next();
+            prev = t.text;
+            continue;
+        } else {
+            emit(NumericType::NUMBER, p.value, p.begin, p.end);
+        }
+        prev = std::string_view();
+    }
+
+    return count;
+}
+
+std::string NumberParser::format(const NumericEntity& entity) {
+    char buffer[32];
+
+    if (entity.type == NumericType::TIME) {
+        int minutes = static_cast<int>(entity.value);
+        std::snprintf(buffer, sizeof(buffer), "%02d:%02d", minutes / 60, minutes % 60);
+        return buffer;
+    }
+
+    if (std::fabs(entity.value) >= 1e15) {
+        std::snprintf(buffer, sizeof(buffer), "%g", entity.value);
+        return buffer;
+    }
+
+    if (entity.value == std::floor(entity.value)) {
+        std::snprintf(buffer, sizeof(buffer), "%.0f", entity.value);
+        return buffer;
+    }
+
+    std::snprintf(buffer, sizeof(buffer), "%.3f", entity.value);
+    std::string text = buffer;
+    while (text.back() == '0') text.pop_back();
+    if (text.back() == '.') text.pop_back();
+    return text;
+}
+
+}
@@ -0,0 +1,109 @@
+#include "pattern_matcher.h"
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+namespace VietIntent {
+
+PatternMatcher::PatternMatcher() {
+    std::memset(byte_class, 0, sizeof(byte_class));
+}
+
+int PatternMatcher::add(const std::string& key) {
+    auto it = key_ids.find(key);
+    if (it != key_ids.end()) {
+        return it->second;
+    }
+
+    int id = static_cast<int>(keys.size());
+    keys.push_back(key);
+    key_ids.emplace(key, id);
+    return id;
+}
+
+void PatternMatcher::build() {
+    // Gom các byte xuất hiện trong khóa thành lớp; byte còn lại dùng chung lớp 0
+    std::memset(byte_class, 0, sizeof(byte_class));
+    alphabet_size = 1;
+    for (const auto& k : keys) {
+        for (unsigned char c : k) {
+            if (byte_class[c] == 0) {
+                byte_class[c] = static_cast<uint8_t>(alphabet_size++);
+            }
+        }
+    }
+
+    // Dựng trie
+    std::vector<std::vector<int>> trie(1, std::vector<int>(alphabet_size, -1));
+    std::vector<std::vector<int>> own_outputs(1);
+
+    for (size_t id = 0; id < keys.size(); ++id) {
+        int node = ROOT;
+        for (unsigned char c : keys[id]) {
+            int& next = trie[node][byte_class[c]];
+            if (next < 0) {
+                next = static_cast<int>(trie.size());
+                trie.emplace_back(alphabet_size, -1);
+                own_outputs.emplace_back();
+            }
+            node = trie[node][byte_class[c]];
+        }
+        own_outputs[node].push_back(static_cast<int>(id));
+    }
+
+    // BFS: tính failure link và chuyển toàn bộ thành DFA
+    const size_t n = trie.size();
+    std::vector<int> fail(n, ROOT);
+    std::vector<int> order;
+    order.reserve(n);
+
+    std::queue<int> queue;
+    for (size_t c = 0; c < alphabet_size; ++c) {
+        int& next = trie[ROOT][c];
+        if (next < 0) {
+            next = ROOT;
+        } else {
+            fail[next] = ROOT;
+            queue.push(next);
+        }
+    }
+    // Lớp 0 không khớp khóa nào nên luôn quay về gốc
+    trie[ROOT][0] = ROOT;
+
+    while (!queue.empty()) {
+        int node = queue.front();
+        queue.pop();
+        order.push_back(node);
+
+        for (size_t c = 0; c < alphabet_size; ++c) {
+            int& next = trie[node][c];
+            if (next < 0) {
+                next = trie[fail[node]][c];
+            } else {
+                fail[next] = trie[fail[node]][c];
+                queue.push(next);
+            }
+        }
+    }
+
+    // Gộp output theo failure link (cha xử lý trước con trong thứ tự BFS)
+    std::vector<std::vector<int>> all_outputs = own_outputs;
+    for (int node : order) {
+        const auto& inherited = all_outputs[fail[node]];
+        all_outputs[node].insert(all_outputs[node].end(), inherited.begin(), inherited.end());
+    }
+
+    transitions.assign(n * alphabet_size, ROOT);
+    output_begin.assign(n + 1, 0);
+    outputs.clear();
+
+    for (size_t node = 0; node < n; ++node) {
+        std::copy(trie[node].begin(), trie[node].end(),
+                  transitions.begin() + node * alphabet_size);
+        output_begin[node] = static_cast<uint32_t>(outputs.size());
+        outputs.insert(outputs.end(), all_outputs[node].begin(), all_outputs[node].end());
+    }
+    output_begin[n] = static_cast<uint32_t>(outputs.size());
+}
+
+}
@@ -0,0 +1,293 @@
+#include "query_capture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace VietIntent {
+
+namespace {
+
+// Chép tối đa capacity byte, không cắt đôi ký tự UTF-8
+size_t copy_utf8(char* dst, size_t capacity, const std::string& src) {
+    size_t length = src.size();
+    if (length > capacity) {
+        length = capacity;
+        while (length > 0 && (static_cast<unsigned char>(src[length]) & 0xC0) == 0x80) {
+            --length;
+        }
+    }
+    std::memcpy(dst, src.data(), length);
+    return length;
+}
+
+void append_json_string(std::string& out, const char* text, size_t length) {
+    out += '"';
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += static_cast<char>(c);
+                }
+        }
+    }
+    out += '"';
+}
+
+void append_json_name(std::string& out, const char* name) {
+    append_json_string(out, name, std::strlen(name));
+}
+
+void append_number(std::string& out, double value) {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.6g", value);
+    out += number;
+}
+
+void append_json(std::string& out, const CaptureRecord& r) {
+    out += "{\"ts\":";
+    out += std::to_string(r.timestamp_us);
+    out += ",\"input\":";
+    append_json_string(out, r.input, r.input_length);
+    if (r.input_truncated) out += ",\"truncated\":true";
+    out += ",\"normalized\":";
+    append_json_string(out, r.normalized, r.normalized_length);
+    out += ",\"intent\":";
+    append_json_name(out, r.intent);
+    out += ",\"confidence\":";
+    append_number(out, r.confidence);
+    out += ",\"stages\":";
+    out += std::to_string(r.stages);
+    out += ",\"degraded\":";
+    out += r.degraded ? "true" : "false";
+    out += ",\"scores\":{";
+    for (size_t i = 0; i < r.score_count; ++i) {
+        const auto& score = r.scores[i];
+        if (i > 0) out += ',';
+        append_json_name(out, score.intent);
+        out += ":{\"match\":";
+        append_number(out, score.match);
+        out += ",\"similarity\":";
+        append_number(out, score.similarity);
+        out += ",\"score\":";
+        append_number(out, score.score);
+        out += '}';
+    }
+    out += "}}\n";
+}
+
+// xorshift64*, hạt giống riêng cho mỗi thread
+uint64_t next_random() {
+    thread_local uint64_t state = [] {
+        uint64_t seed = static_cast<uint64_t>(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        seed ^= reinterpret_cast<uintptr_t>(&seed) * 0x9e3779b97f4a7c15ULL;
+        return seed ? seed : 0x2545f4914f6cdd1dULL;
+    }();
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
+
+size_t round_up_pow2(size_t n) {
+    size_t capacity = 2;
+    while (capacity < n) capacity <<= 1;
+    return capacity;
+}
+
+}
+
+void CaptureRecord::set_input(const std::string& text) {
+    input_length = static_cast<uint16_t>(copy_utf8(input, TEXT_SIZE, text));
+    input_truncated = input_length < text.size();
+}
+
+void CaptureRecord::set_normalized(const std::string& text) {
+    normalized_length = static_cast<uint16_t>(copy_utf8(normalized, TEXT_SIZE, text));
+}
+
+void CaptureRecord::set_name(char* dst, const std::string& name) {
+    size_t length = std::min(name.size(), NAME_SIZE - 1);
+    std::memcpy(dst, name.data(), length);
+    dst[length] = '\0';
+}
+
+void CaptureScores::add(int index, const CaptureRecord::Score& score) {
+    if (count < CaptureRecord::MAX_SCORES) {
+        entries[count] = score;
+        indices[count] = index;
+        ++count;
+        return;
+    }
+    // Đầy: thay điểm thấp nhất (hòa điểm thì intent đứng sau trong model)
+    size_t lowest = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (entries[i].score < entries[lowest].score ||
+            (entries[i].score == entries[lowest].score && indices[i] > indices[lowest])) {
+            lowest = i;
+        }
+    }
+    if (score.score > entries[lowest].score) {
+        entries[lowest] = score;
+        indices[lowest] = index;
+    }
+}
+
+void CaptureScores::set_winner(int index, const CaptureRecord::Score& score) {
+    winner = score;
+    winner_index = index;
+}
+
+size_t CaptureScores::copy_to(CaptureRecord::Score* out) const {
+    struct Ranked {
+        const CaptureRecord::Score* score;
+        int index;
+    };
+    Ranked ranked[CaptureRecord::MAX_SCORES];
+    size_t n = count;
+    bool has_winner = winner_index < 0;
+    for (size_t i = 0; i < n; ++i) {
+        ranked[i] = {&entries[i], indices[i]};
+        has_winner = has_winner || indices[i] == winner_index;
+    }
+
+    auto higher = [](const Ranked& a, const Ranked& b) {
+        if (a.score->score != b.score->score) return a.score->score > b.score->score;
+        return a.index < b.index;
+    };
+    std::sort(ranked, ranked + n, higher);
+
+    // Intent thắng luôn có mặt, kể cả khi các intent dưới ngưỡng có điểm cao hơn
+    if (!has_winner) {
+        if (n < CaptureRecord::MAX_SCORES) ++n;
+        ranked[n - 1] = {&winner, winner_index};
+        std::sort(ranked, ranked + n, higher);
+    }
+
+    for (size_t i = 0; i < n; ++i) out[i] = *ranked[i].score;
+    return n;
+}
+
+CaptureRing::CaptureRing(size_t capacity)
+    : slots(new Slot[round_up_pow2(capacity)]), mask(round_up_pow2(capacity) - 1) {
+    for (size_t i = 0; i <= mask; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+QueryCapture::QueryCapture(const CaptureConfig& cfg)
+    : config(cfg),
+      threshold(0),
+      sample_all(cfg.sample_rate >= 1.0),
+      ring(cfg.buffer_records) {
+    if (!sample_all && cfg.sample_rate > 0.0) {
+        threshold = static_cast<uint64_t>(cfg.sample_rate * 18446744073709551616.0);
+    }
+}
+
+QueryCapture::~QueryCapture() {
+    stop();
+}
+
+bool QueryCapture::start() {
+    file.open(config.path, std::ios::binary | std::ios::app);
+    if (!file) return false;
+    file.seekp(0, std::ios::end);
+    file_bytes = static_cast<uint64_t>(std::max<std::streamoff>(file.tellp(), 0));
+
+    writer = std::thread(&QueryCapture::run, this);
+    return true;
+}
+
+void QueryCapture::stop() {
+    // Không nhận bản ghi mới, chờ producer đang đẩy xong để lần flush cuối ghi được
+    closed.store(true, std::memory_order_seq_cst);
+    while (producers.load(std::memory_order_seq_cst) > 0) std::this_thread::yield();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (writer.joinable()) writer.join();
+    if (file.is_open()) file.close();
+}
+
+bool QueryCapture::sample() const {
+    return sample_all || (threshold != 0 && next_random() < threshold);
+}
+
+CaptureStats QueryCapture::stats() const {
+    CaptureStats stats;
+    stats.captured = captured.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.written = written.load(std::memory_order_relaxed);
+    stats.rotations = rotations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void QueryCapture::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        wake.wait_for(lock, config.flush_interval, [this] { return stopping; });
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+    // stop() có thể đến trước lần chờ đầu tiên hoặc trong lúc flush
+    lock.unlock();
+    flush();
+}
+
+// Gom bản ghi đang chờ theo lô (tối đa một vòng ring mỗi lần ghi)
+void QueryCapture::flush() {
+    const size_t batch = ring.capacity();
+    size_t count;
+    do {
+        count = 0;
+        buffer.clear();
+        while (count < batch &&
+               ring.try_consume([&](const CaptureRecord& record) { append_json(buffer, record); })) {
+            ++count;
+        }
+        if (count == 0) return;
+
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        file.flush();
+        file_bytes += buffer.size();
+        written.fetch_add(count, std::memory_order_relaxed);
+
+        if (file_bytes >= config.max_file_bytes) rotate();
+    } while (count == batch);
+}
+
+// path -> path.1 -> ... -> path.N (file cũ nhất bị ghi đè)
+void QueryCapture::rotate() {
+    file.close();
+    if (config.max_files == 0) {
+        std::remove(config.path.c_str());
+    } else {
+        for (size_t i = config.max_files; i > 1; --i) {
+            std::string from = config.path + "." + std::to_string(i - 1);
+            std::string to = config.path + "." + std::to_string(i);
+            std::rename(from.c_str(), to.c_str());
+        }
+        std::rename(config.path.c_str(), (config.path + ".1").c_str());
+    }
+    file.open(config.path, std::ios::binary | std::ios::trunc);
+    file_bytes = 0;
+    rotations.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
@@ -78,8 +78,13 @@ std::string TextPreprocessor::normalize(const std::string& text) {
         result += ch;
     }
 
-    // Xóa dấu
+    // Xóa dấu (chữ hoa có dấu trả về chữ hoa ASCII nên hạ thường lần nữa)
     result = remove_diacritics(result);
+    for (auto& c : result) {
+        if (static_cast<unsigned char>(c) < 128) {
+            c = std::tolower(c);
+        }
+    }
 
     // Xóa khoảng trắng thừa và ký tự đặc biệt
     std::stringstream ss(result);
@@ -129,6 +134,20 @@ std::vector<std::string> TextPreprocessor::tokenize(const std::string& text) {
     return tokens;
 }
 
+std::vector<std::string> TextPreprocessor::keyword_tokens(const std::string& text) {
+    std::vector<std::string> keywords;
+    for (auto& token : tokenize(text)) {
+        size_t chars = 0;
+        bool digits = true;
+        for (unsigned char c : token) {
+            if ((c & 0xC0) != 0x80) ++chars;
+            if (!std::isdigit(c)) digits = false;
+        }
+        if (chars >= 2 && !digits) keywords.push_back(std::move(token));
+    }
+    return keywords;
+}
+
 std::string TextPreprocessor::remove_diacritics(const std::string& text) {
     if (text.empty()) return "";
 
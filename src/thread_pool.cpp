@@ -0,0 +1,88 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <future>
+#include <memory>
+
+namespace VietIntent {
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    shutdown();
+}
+
+bool ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return false;
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+    return true;
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t, size_t)>& fn) {
+    // Vài đoạn mỗi worker để cân bằng khi các phần tử nặng nhẹ khác nhau
+    size_t chunks = std::min(count, workers.size() * 4);
+    if (chunks <= 1) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+
+    std::vector<std::future<void>> done;
+    done.reserve(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t begin = count * c / chunks;
+        size_t end = count * (c + 1) / chunks;
+        auto task = std::make_shared<std::packaged_task<void()>>([&fn, begin, end] { fn(begin, end); });
+        done.push_back(task->get_future());
+        if (!submit([task] { (*task)(); })) (*task)();
+    }
+    for (auto& f : done) f.wait();
+    for (auto& f : done) f.get();
+}
+
+size_t ThreadPool::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size() + running;
+}
+
+void ThreadPool::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (tasks.empty()) return;   // stopping và đã hết việc
+
+        auto task = std::move(tasks.front());
+        tasks.pop_front();
+        ++running;
+        lock.unlock();
+        try {
+            task();
+        } catch (...) {
+        }
+        lock.lock();
+        --running;
+    }
+}
+
+}
@@ -8,14 +8,22 @@ namespace VietIntent {
 
 class IntentEngine::Impl {
 public:
+    explicit Impl(Pipeline pipeline) : detector(pipeline) {}
+
     IntentDetector detector;
     bool initialized = false;
 };
 
-IntentEngine::IntentEngine() : pimpl(std::make_unique<Impl>()) {
+IntentEngine::IntentEngine() : IntentEngine(Pipeline::FULL) {}
+
+IntentEngine::IntentEngine(Pipeline pipeline) : pimpl(std::make_unique<Impl>(pipeline)) {
     pimpl->initialized = true;
 }
 
+Pipeline IntentEngine::pipeline() const {
+    return pimpl->detector.pipeline();
+}
+
 IntentEngine::~IntentEngine() = default;
 
 bool IntentEngine::initialize(const std::string& model_path) {
@@ -31,6 +39,34 @@ IntentResult IntentEngine::detect(const std::string& text) {
     return pimpl->detector.detect(text);
 }
 
+IntentResult IntentEngine::detect(const std::string& text, const DetectOptions& options) {
+    if (!pimpl->initialized) {
+        initialize();
+    }
+    return pimpl->detector.detect(text, options);
+}
+
+BatchResult IntentEngine::detect_batch(const std::vector<std::string>& texts) {
+    if (!pimpl->initialized) {
+        initialize();
+    }
+    return pimpl->detector.detect_batch(texts);
+}
+
+std::vector<IntentSpan> IntentEngine::detect_multi(const std::string& text) {
+    if (!pimpl->initialized) {
+        initialize();
+    }
+    return pimpl->detector.detect_multi(text);
+}
+
+std::unique_ptr<DetectionSession> IntentEngine::create_session() {
+    if (!pimpl->initialized) {
+        initialize();
+    }
+    return pimpl->detector.create_session();
+}
+
 void IntentEngine::add_intent(const std::string& intent_name,
                              const std::vector<std::string>& patterns,
                              const std::string& response_pattern) {
@@ -40,13 +76,93 @@ void IntentEngine::add_intent(const std::string& intent_name,
 
     // Tự động tạo keywords từ patterns
     for (const auto& p : patterns) {
-        auto tokens = TextPreprocessor::tokenize(p);
+        auto tokens = TextPreprocessor::keyword_tokens(p);
         pattern.keywords.insert(pattern.keywords.end(), tokens.begin(), tokens.end());
     }
 
     pimpl->detector.add_intent(intent_name, pattern, response_pattern);
 }
 
+BuildStats IntentEngine::add_intents(const std::vector<IntentSpec>& specs, size_t threads) {
+    return pimpl->detector.add_intents(specs, threads);
+}
+
+BuildStats IntentEngine::build_stats() const {
+    return pimpl->detector.build_stats();
+}
+
+void IntentEngine::set_prefilter(const PrefilterConfig& config) {
+    pimpl->detector.set_prefilter(config);
+}
+
+PrefilterConfig IntentEngine::prefilter() const {
+    return pimpl->detector.prefilter();
+}
+
+PrefilterStats IntentEngine::prefilter_stats() const {
+    return pimpl->detector.prefilter_stats();
+}
+
+void IntentEngine::reset_prefilter_stats() {
+    pimpl->detector.reset_prefilter_stats();
+}
+
+void IntentEngine::set_load_level(LoadLevel level) {
+    pimpl->detector.set_load_level(level);
+}
+
+LoadLevel IntentEngine::load_level() const {
+    return pimpl->detector.load_level();
+}
+
+DegradationStats IntentEngine::degradation_stats() const {
+    return pimpl->detector.degradation_stats();
+}
+
+void IntentEngine::reset_degradation_stats() {
+    pimpl->detector.reset_degradation_stats();
+}
+
+bool IntentEngine::start_capture(const CaptureConfig& config) {
+    return pimpl->detector.start_capture(config);
+}
+
+void IntentEngine::stop_capture() {
+    pimpl->detector.stop_capture();
+}
+
+CaptureStats IntentEngine::capture_stats() const {
+    return pimpl->detector.capture_stats();
+}
+
+void IntentEngine::set_adaptive_order(bool enabled) {
+    pimpl->detector.set_adaptive_order(enabled);
+}
+
+bool IntentEngine::adaptive_order() const {
+    return pimpl->detector.adaptive_order();
+}
+
+std::vector<std::string> IntentEngine::evaluation_order() {
+    return pimpl->detector.evaluation_order();
+}
+
+bool IntentEngine::load_order_stats(const std::string& filepath) {
+    return pimpl->detector.load_order_stats(filepath);
+}
+
+bool IntentEngine::save_order_stats(const std::string& filepath) {
+    return pimpl->detector.save_order_stats(filepath);
+}
+
+EvaluationStats IntentEngine::evaluation_stats() const {
+    return pimpl->detector.evaluation_stats();
+}
+
+void IntentEngine::reset_evaluation_stats() {
+    pimpl->detector.reset_evaluation_stats();
+}
+
 void IntentEngine::load_patterns_from_file(const std::string& filepath) {
     pimpl->detector.load_from_json(filepath);
 }
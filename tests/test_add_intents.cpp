@@ -0,0 +1,119 @@
+// Kiểm thử add_intents: model (fingerprint, kích thước, kết quả nhận dạng) không
+// phụ thuộc số thread và giống add_intent tuần tự; keyword tự sinh không lấy token
+// một ký tự hay chỉ gồm chữ số, và trùng khớp hoàn toàn thắng khi hòa điểm.
+#include "viet_intent.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+const char* SYLLABLES[] = {"đặt", "phòng", "khách", "sạn", "thuê", "xe", "máy",
+                           "vé", "tàu", "bay", "hủy", "đơn", "giao", "hàng"};
+const size_t SYLLABLE_COUNT = sizeof(SYLLABLES) / sizeof(SYLLABLES[0]);
+
+std::vector<IntentSpec> make_specs(size_t intents, size_t patterns) {
+    std::vector<IntentSpec> specs;
+    for (size_t i = 0; i < intents; ++i) {
+        IntentSpec spec;
+        spec.name = "bulk_" + std::to_string(i);
+        for (size_t j = 0; j < patterns; ++j) {
+            std::string pattern = std::string(SYLLABLES[(i * 7 + j) % SYLLABLE_COUNT]) + " " +
+                                  SYLLABLES[(i * 3 + j * 5) % SYLLABLE_COUNT] + " k" +
+                                  std::to_string(i) + " " + std::to_string(j);
+            spec.patterns.push_back(pattern);
+            if (j % 5 == 0) spec.patterns.push_back(pattern);   // pattern trùng
+        }
+        if (i % 2 == 0) spec.keywords = {"k" + std::to_string(i)};
+        spec.response_pattern = "r" + std::to_string(i);
+        specs.push_back(spec);
+    }
+    return specs;
+}
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+    auto fail = [&](const std::string& message) {
+        std::cerr << "FAIL " << message << "\n";
+        ++failures;
+    };
+
+    const auto specs = make_specs(300, 20);
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < 300; i += 7) {
+        queries.push_back(std::string("tôi muốn ") + SYLLABLES[(i * 7 + 3) % SYLLABLE_COUNT] +
+                          " " + SYLLABLES[(i * 3 + 15) % SYLLABLE_COUNT] + " k" +
+                          std::to_string(i) + " 3");
+    }
+    queries.push_back("xin chào");
+    queries.push_back("giá bao nhiêu");
+
+    // Một thread và nhiều thread cho cùng model
+    IntentEngine single(Pipeline::NO_ENTITIES), parallel(Pipeline::NO_ENTITIES);
+    BuildStats one = single.add_intents(specs, 1);
+    BuildStats many = parallel.add_intents(specs, 4);
+    if (one.fingerprint == 0 || one.fingerprint != many.fingerprint || one.keys != many.keys ||
+        one.states != many.states || one.duplicates != many.duplicates ||
+        one.intents != many.intents) {
+        fail("model differs between 1 and 4 threads");
+    }
+    for (const auto& query : queries) {
+        IntentResult a = single.detect(query), b = parallel.detect(query);
+        if (a.intent != b.intent || a.confidence != b.confidence ||
+            a.response_pattern != b.response_pattern) {
+            fail("\"" + query + "\": " + a.intent + " with 1 thread, " + b.intent +
+                 " with 4 threads");
+        }
+    }
+
+    // add_intent tuần tự cho cùng model với add_intents (spec không có keyword)
+    {
+        std::vector<IntentSpec> plain = specs;
+        IntentEngine sequential(Pipeline::NO_ENTITIES), bulk(Pipeline::NO_ENTITIES);
+        for (auto& spec : plain) {
+            spec.keywords.clear();
+            sequential.add_intent(spec.name, spec.patterns, spec.response_pattern);
+        }
+        sequential.detect("xin chào");   // dựng model
+        BuildStats built = bulk.add_intents(plain, 3);
+        if (sequential.build_stats().fingerprint != built.fingerprint) {
+            fail("add_intent and add_intents build different models");
+        }
+    }
+
+    // Token "5" không thành keyword: câu trùng khớp pattern của custom_5 không bị
+    // bulk_5 (có pattern chứa "5") lấy mất
+    {
+        IntentEngine engine(Pipeline::NO_ENTITIES);
+        std::vector<IntentSpec> numbered;
+        for (int i = 0; i < 10; ++i) {
+            IntentSpec spec;
+            spec.name = "bulk_" + std::to_string(i);
+            spec.patterns = {"5 " + std::to_string(i) + " alpha", "ma 5 alpha " +
+                             std::to_string(i)};
+            numbered.push_back(spec);
+        }
+        IntentSpec custom;
+        custom.name = "custom_5";
+        custom.patterns = {"custom_5 alpha"};
+        numbered.push_back(custom);
+        engine.add_intents(numbered, 2);
+
+        IntentResult result = engine.detect("custom_5 alpha");
+        if (result.intent != "custom_5") {
+            fail("\"custom_5 alpha\" resolves to " + result.intent + " " +
+                 std::to_string(result.confidence));
+        }
+    }
+
+    std::cout.rdbuf(old);
+    if (failures == 0) std::cout << "passed\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+// Kiểm thử lấy mẫu truy vấn: bản ghi được ghi ra file, capture đã dừng hoặc bị
+// thay không còn giữ file mở, bản ghi đến sau khi dừng được tính là dropped,
+// lấy mẫu không tắt cắt tỉa, và điểm ghi lại luôn có intent thắng dù model có
+// nhiều hơn MAX_SCORES intent.
+#include "viet_intent.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+// Số file descriptor đang mở của tiến trình (-1 nếu không có /proc)
+int open_descriptors() {
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir) return -1;
+    int count = 0;
+    while (readdir(dir)) ++count;
+    closedir(dir);
+    return count;
+}
+
+size_t count_lines(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    size_t lines = 0;
+    while (std::getline(in, line)) ++lines;
+    return lines;
+}
+
+std::string last_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line, last;
+    while (std::getline(in, line)) last = line;
+    return last;
+}
+
+size_t count_of(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos;
+         pos = text.find(needle, pos + needle.size())) {
+        ++count;
+    }
+    return count;
+}
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+
+    const std::string path = "test_capture.jsonl";
+    std::remove(path.c_str());
+
+    IntentEngine engine(Pipeline::NO_ENTITIES);
+    CaptureConfig config;
+    config.path = path;
+    config.sample_rate = 1.0;
+    config.buffer_records = 64;
+
+    // Bản ghi đang chờ được ghi ra khi dừng
+    if (!engine.start_capture(config)) {
+        std::cerr << "FAIL cannot open " << path << "\n";
+        return 1;
+    }
+    for (int i = 0; i < 10; ++i) engine.detect("giá bánh mì bao nhiêu");
+    engine.stop_capture();
+    if (count_lines(path) != 10 || engine.capture_stats().written != 10) {
+        std::cerr << "FAIL expected 10 records, got " << count_lines(path) << "\n";
+        ++failures;
+    }
+
+    // Bật/tắt và thay capture nhiều lần không để lại file mở
+    int before = open_descriptors();
+    for (int i = 0; i < 50; ++i) {
+        engine.start_capture(config);
+        engine.detect("xin chào");
+        engine.start_capture(config);   // thay capture đang chạy
+        engine.detect("cảm ơn");
+        engine.stop_capture();
+    }
+    int after = open_descriptors();
+    if (before >= 0 && after != before) {
+        std::cerr << "FAIL open descriptors: " << before << " -> " << after << "\n";
+        ++failures;
+    }
+    if (count_lines(path) != 110) {
+        std::cerr << "FAIL expected 110 records, got " << count_lines(path) << "\n";
+        ++failures;
+    }
+
+    // Capture dừng khi các thread khác đang nhận dạng: mọi bản ghi đã tính là
+    // captured đều được ghi, bản ghi đến muộn tính là dropped
+    for (int round = 0; round < 20; ++round) {
+        std::remove(path.c_str());
+        engine.start_capture(config);
+        std::atomic<bool> running{true};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 2; ++t) {
+            threads.emplace_back([&] {
+                while (running.load()) engine.detect("cho tôi 2 tô phở bò");
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        engine.stop_capture();
+        running = false;
+        for (auto& thread : threads) thread.join();
+
+        CaptureStats stats = engine.capture_stats();
+        if (stats.captured != stats.written || count_lines(path) != stats.written) {
+            std::cerr << "FAIL round " << round << ": captured " << stats.captured
+                      << ", written " << stats.written << ", lines " << count_lines(path)
+                      << ", dropped " << stats.dropped << "\n";
+            ++failures;
+            break;
+        }
+    }
+
+    // Lấy mẫu không tắt cắt tỉa: số intent được chấm như khi không capture
+    {
+        const std::vector<std::string> texts = {"xin chào", "giá bánh mì bao nhiêu",
+                                                "mấy giờ rồi", "cho tôi 2 tô phở bò"};
+        engine.reset_evaluation_stats();
+        for (const auto& text : texts) engine.detect(text);
+        EvaluationStats plain = engine.evaluation_stats();
+
+        engine.start_capture(config);
+        engine.reset_evaluation_stats();
+        for (const auto& text : texts) engine.detect(text);
+        EvaluationStats sampled = engine.evaluation_stats();
+        engine.stop_capture();
+
+        if (sampled.intents_scored != plain.intents_scored || sampled.intents_pruned == 0) {
+            std::cerr << "FAIL capture changes pruning: scored " << plain.intents_scored
+                      << " -> " << sampled.intents_scored << ", pruned "
+                      << sampled.intents_pruned << "\n";
+            ++failures;
+        }
+    }
+
+    // Nhiều hơn MAX_SCORES intent: intent thắng đứng sau trong model vẫn được ghi
+    {
+        std::remove(path.c_str());
+        IntentEngine wide(Pipeline::NO_ENTITIES);
+        const char* words[] = {"alpha", "beta", "gamma", "delta", "epsilon", "zeta",
+                               "eta", "theta", "iota", "kappa", "lambda", "omega"};
+        for (int i = 0; i < 12; ++i) {
+            wide.add_intent("wide_" + std::to_string(i), {std::string("ma lenh ") + words[i]});
+        }
+        // Tên xếp theo thứ tự chữ nên wide_9 đứng sau cùng trong 12 intent này
+        wide.start_capture(config);
+        IntentResult result = wide.detect("ma lenh kappa");
+        wide.stop_capture();
+
+        const std::string line = last_line(path);
+        const size_t scores = line.find("\"scores\":{");
+        const std::string recorded = scores == std::string::npos ? "" : line.substr(scores);
+        if (result.intent != "wide_9" ||
+            recorded.find("\"wide_9\":{\"match\":1") == std::string::npos ||
+            count_of(recorded, "\"match\":") > 8) {
+            std::cerr << "FAIL winner missing from captured scores: " << result.intent << " "
+                      << recorded << "\n";
+            ++failures;
+        }
+    }
+
+    std::remove(path.c_str());
+    std::cout.rdbuf(old);
+    std::cout << (failures == 0 ? "passed" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
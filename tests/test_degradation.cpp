@@ -0,0 +1,142 @@
+// Kiểm thử giảm tải: mặt nạ stages và cờ degraded theo biến thể pipeline, mức
+// tải và ngân sách thời gian, cùng các bộ đếm DegradationStats.
+#include "viet_intent.h"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace VietIntent;
+
+namespace {
+
+const uint32_t SCORING = STAGE_EXACT | STAGE_CONTAINS | STAGE_KEYWORDS | STAGE_SIMILARITY |
+                         STAGE_HEURISTICS;
+const uint32_t FAST_SCORING = STAGE_EXACT | STAGE_KEYWORDS;
+
+struct Case {
+    Pipeline pipeline;
+    LoadLevel level;
+    uint32_t stages;
+    bool degraded;
+};
+
+const Case CASES[] = {
+    {Pipeline::FULL, LoadLevel::NORMAL, SCORING | STAGE_ENTITIES, false},
+    {Pipeline::FULL, LoadLevel::ELEVATED, SCORING, true},
+    {Pipeline::FULL, LoadLevel::CRITICAL, SCORING & ~STAGE_SIMILARITY, true},
+    // Biến thể không có bước nào thì bỏ bước đó không tính là giảm tải
+    {Pipeline::NO_ENTITIES, LoadLevel::NORMAL, SCORING, false},
+    {Pipeline::NO_ENTITIES, LoadLevel::ELEVATED, SCORING, false},
+    {Pipeline::NO_ENTITIES, LoadLevel::CRITICAL, SCORING & ~STAGE_SIMILARITY, true},
+    {Pipeline::FAST, LoadLevel::NORMAL, FAST_SCORING, false},
+    {Pipeline::FAST, LoadLevel::CRITICAL, FAST_SCORING, false},
+};
+
+const char* level_name(LoadLevel level) {
+    switch (level) {
+        case LoadLevel::NORMAL: return "normal";
+        case LoadLevel::ELEVATED: return "elevated";
+        case LoadLevel::CRITICAL: return "critical";
+    }
+    return "?";
+}
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+    const std::string text = "tôi muốn đặt 2 phở bò";
+
+    for (const auto& c : CASES) {
+        IntentEngine engine(c.pipeline);
+        engine.set_load_level(c.level);
+        IntentResult result = engine.detect(text);
+        if (result.stages != c.stages || result.degraded != c.degraded) {
+            std::cerr << "FAIL pipeline " << static_cast<int>(c.pipeline) << " "
+                      << level_name(c.level) << ": stages 0x" << std::hex << result.stages
+                      << " (expected 0x" << c.stages << ")" << std::dec << " degraded "
+                      << result.degraded << "\n";
+            ++failures;
+        }
+        if (!(result.stages & STAGE_ENTITIES) && !result.entities.empty()) {
+            std::cerr << "FAIL entities returned without STAGE_ENTITIES\n";
+            ++failures;
+        }
+
+        DegradationStats stats = engine.degradation_stats();
+        if (stats.requests != 1 || stats.degraded != (c.degraded ? 1u : 0u)) {
+            std::cerr << "FAIL pipeline " << static_cast<int>(c.pipeline) << " "
+                      << level_name(c.level) << ": requests " << stats.requests
+                      << " degraded " << stats.degraded << "\n";
+            ++failures;
+        }
+    }
+
+    // Bộ đếm theo bước bị bỏ
+    {
+        IntentEngine engine(Pipeline::FULL);
+        engine.set_load_level(LoadLevel::CRITICAL);
+        engine.detect(text);
+        engine.set_load_level(LoadLevel::ELEVATED);
+        engine.detect(text);
+        DegradationStats stats = engine.degradation_stats();
+        if (stats.requests != 2 || stats.degraded != 2 || stats.similarity_skipped != 1 ||
+            stats.entities_skipped != 2 || stats.budget_exceeded != 0) {
+            std::cerr << "FAIL skip counters: similarity " << stats.similarity_skipped
+                      << " entities " << stats.entities_skipped << "\n";
+            ++failures;
+        }
+        engine.reset_degradation_stats();
+        if (engine.degradation_stats().requests != 0) {
+            std::cerr << "FAIL reset_degradation_stats\n";
+            ++failures;
+        }
+    }
+
+    // Ngân sách đã hết trước bước độ tương đồng: bỏ độ tương đồng và thực thể
+    {
+        IntentEngine engine(Pipeline::FULL);
+        DetectOptions options;
+        options.budget = std::chrono::microseconds(1);
+        std::string long_text;
+        for (int i = 0; i < 200; ++i) long_text += "tôi muốn đặt 2 phở bò ";
+        IntentResult result = engine.detect(long_text, options);
+        DegradationStats stats = engine.degradation_stats();
+        if (!result.degraded || (result.stages & (STAGE_SIMILARITY | STAGE_ENTITIES)) ||
+            !(result.stages & STAGE_EXACT) || stats.budget_exceeded != 1) {
+            std::cerr << "FAIL budget: stages 0x" << std::hex << result.stages << std::dec
+                      << " degraded " << result.degraded << " budget_exceeded "
+                      << stats.budget_exceeded << "\n";
+            ++failures;
+        }
+
+        // Ngân sách rộng: không bỏ bước nào
+        options.budget = std::chrono::seconds(10);
+        result = engine.detect(text, options);
+        if (result.degraded || result.stages != (SCORING | STAGE_ENTITIES)) {
+            std::cerr << "FAIL generous budget degraded the result\n";
+            ++failures;
+        }
+    }
+
+    // Bộ lọc bật thì có thêm STAGE_PREFILTER
+    {
+        IntentEngine engine(Pipeline::NO_ENTITIES);
+        PrefilterConfig config;
+        config.enabled = true;
+        engine.set_prefilter(config);
+        IntentResult result = engine.detect(text);
+        if (result.stages != (STAGE_PREFILTER | SCORING)) {
+            std::cerr << "FAIL prefilter stage: 0x" << std::hex << result.stages << std::dec
+                      << "\n";
+            ++failures;
+        }
+    }
+
+    std::cout.rdbuf(old);
+    if (failures == 0) std::cout << "passed\n";
+    return failures == 0 ? 0 : 1;
+}
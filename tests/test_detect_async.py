@@ -0,0 +1,71 @@
+"""detect_async: kết quả khớp detect(), hủy một yêu cầu không ảnh hưởng các yêu
+cầu khác, và loop đã đóng không bị binding giữ lại."""
+
+import asyncio
+import gc
+import time
+import weakref
+
+import pytest
+
+viet_intent = pytest.importorskip("viet_intent")
+
+SENTENCES = [
+    "xin chào",
+    "cho tôi 2 tô phở bò",
+    "giá bánh mì bao nhiêu",
+    "mấy giờ rồi",
+    "cảm ơn bạn nhiều",
+    "tạm biệt nhé",
+    "tôi muốn đặt bàn cho 4 người",
+    "đăng ký khóa học yoga",
+]
+
+
+def test_detect_async_matches_detect():
+    engine = viet_intent.IntentEngine("no-entities")
+    texts = SENTENCES * 64
+    cancelled = 5
+
+    async def run():
+        futures = [engine.detect_async(text) for text in texts]
+        futures[cancelled].cancel()
+        return await asyncio.gather(*futures, return_exceptions=True)
+
+    results = asyncio.run(run())
+
+    assert len(results) == len(texts)
+    assert isinstance(results[cancelled], asyncio.CancelledError)
+    for i, (text, result) in enumerate(zip(texts, results)):
+        if i == cancelled:
+            continue
+        expected = engine.detect(text)
+        assert result.intent == expected.intent, text
+        assert result.confidence == expected.confidence, text
+
+
+def test_closed_loop_is_released():
+    engine = viet_intent.IntentEngine("no-entities")
+    loop = asyncio.new_event_loop()
+
+    async def submit():
+        return [engine.detect_async(text) for text in SENTENCES * 16]
+
+    futures = loop.run_until_complete(submit())
+    loop.close()
+    del futures
+
+    # Kết quả đến sau khi loop đóng bị bỏ, cùng với tham chiếu tới loop
+    ref = weakref.ref(loop)
+    del loop
+    deadline = time.monotonic() + 10.0
+    while ref() is not None and time.monotonic() < deadline:
+        time.sleep(0.01)
+        gc.collect()
+    assert ref() is None
+
+    # Loop mới vẫn dùng được
+    async def one():
+        return await engine.detect_async("xin chào")
+
+    assert asyncio.run(one()).intent == "greeting"
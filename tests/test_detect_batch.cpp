@@ -0,0 +1,101 @@
+// Kiểm thử detect_batch: các cột (intent, độ tin cậy, thực thể) khớp detect()
+// từng câu, và các mảng offset đúng kích thước, không giảm.
+#include "viet_intent.h"
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+    auto fail = [&](const std::string& message) {
+        std::cerr << "FAIL " << message << "\n";
+        ++failures;
+    };
+
+    const std::vector<std::string> texts = {
+        "xin chào",
+        "tôi muốn đặt 2 cơm tấm",
+        "giá bánh mì bao nhiêu",
+        "",
+        "mấy giờ rồi",
+        "đăng ký khóa học yoga",
+        "cho tôi 3 ly cà phê sữa đá",
+        "cảm ơn bạn nhiều",
+    };
+
+    for (Pipeline pipeline : {Pipeline::FULL, Pipeline::NO_ENTITIES, Pipeline::FAST}) {
+        IntentEngine engine(pipeline);
+        BatchResult batch = engine.detect_batch(texts);
+        const std::string tag = "pipeline " + std::to_string(static_cast<int>(pipeline)) + ": ";
+
+        if (batch.intent_names.empty() || batch.intent_names[0] != "unknown") {
+            fail(tag + "intent_names[0] is not \"unknown\"");
+        }
+        if (batch.intent_ids.size() != texts.size() || batch.confidences.size() != texts.size() ||
+            batch.entity_offsets.size() != texts.size() + 1) {
+            fail(tag + "column sizes do not match the number of texts");
+            continue;
+        }
+        if (batch.entity_offsets.front() != 0 ||
+            batch.entity_offsets.back() != static_cast<int64_t>(batch.entity_keys.size())) {
+            fail(tag + "entity_offsets do not span entity_keys");
+        }
+        if (batch.value_offsets.size() != batch.entity_keys.size() + 1 ||
+            batch.value_offsets.front() != 0 ||
+            batch.value_offsets.back() != static_cast<int64_t>(batch.value_data.size())) {
+            fail(tag + "value_offsets do not span value_data");
+            continue;
+        }
+
+        for (size_t i = 0; i < texts.size(); ++i) {
+            IntentResult expected = engine.detect(texts[i]);
+            int32_t id = batch.intent_ids[i];
+            if (id < 0 || static_cast<size_t>(id) >= batch.intent_names.size() ||
+                batch.intent_names[id] != expected.intent) {
+                fail(tag + "\"" + texts[i] + "\": intent differs from detect()");
+                continue;
+            }
+            if (batch.confidences[i] != static_cast<float>(expected.confidence)) {
+                fail(tag + "\"" + texts[i] + "\": confidence differs from detect()");
+            }
+
+            int64_t begin = batch.entity_offsets[i], end = batch.entity_offsets[i + 1];
+            if (begin > end) {
+                fail(tag + "entity_offsets decrease at " + std::to_string(i));
+                continue;
+            }
+            std::map<std::string, std::string> entities;
+            for (int64_t j = begin; j < end; ++j) {
+                int32_t key = batch.entity_keys[j];
+                if (key < 0 || static_cast<size_t>(key) >= batch.entity_names.size()) {
+                    fail(tag + "entity key out of range");
+                    continue;
+                }
+                entities[batch.entity_names[key]] = batch.value_data.substr(
+                    batch.value_offsets[j], batch.value_offsets[j + 1] - batch.value_offsets[j]);
+            }
+            if (entities != expected.entities) {
+                fail(tag + "\"" + texts[i] + "\": entities differ from detect()");
+            }
+        }
+    }
+
+    // Câu gọi món có thực thể số lượng trong cột thực thể
+    IntentEngine engine(Pipeline::FULL);
+    BatchResult batch = engine.detect_batch({"tôi muốn đặt 10 phở bò"});
+    bool quantity = false;
+    for (int64_t j = batch.entity_offsets[0]; j < batch.entity_offsets[1]; ++j) {
+        if (batch.entity_names[batch.entity_keys[j]] == "quantity") quantity = true;
+    }
+    if (!quantity) fail("order sentence has no quantity entity");
+
+    std::cout.rdbuf(old);
+    if (failures == 0) std::cout << "passed\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+"""detect_batch: các cột NumPy khớp detect() từng câu."""
+
+import pytest
+
+np = pytest.importorskip("numpy")
+viet_intent = pytest.importorskip("viet_intent")
+
+TEXTS = [
+    "xin chào",
+    "tôi muốn đặt 2 cơm tấm",
+    "giá bánh mì bao nhiêu",
+    "",
+    "mấy giờ rồi",
+    "cho tôi 3 ly cà phê sữa đá",
+]
+
+
+@pytest.mark.parametrize("pipeline", ["full", "fast", "no-entities"])
+def test_columns_match_detect(pipeline):
+    engine = viet_intent.IntentEngine(pipeline)
+    batch = engine.detect_batch(TEXTS)
+
+    assert batch["intent_names"][0] == "unknown"
+    assert batch["intent_ids"].dtype == np.int32
+    assert batch["confidences"].dtype == np.float32
+    assert len(batch["intent_ids"]) == len(TEXTS)
+    assert len(batch["entity_offsets"]) == len(TEXTS) + 1
+    assert len(batch["value_offsets"]) == len(batch["entity_keys"]) + 1
+    assert batch["entity_offsets"][-1] == len(batch["entity_keys"])
+    assert batch["value_offsets"][-1] == len(batch["value_data"])
+
+    values = batch["value_data"].tobytes()
+    for i, text in enumerate(TEXTS):
+        expected = engine.detect(text)
+        assert batch["intent_names"][batch["intent_ids"][i]] == expected.intent
+        assert batch["confidences"][i] == np.float32(expected.confidence)
+
+        entities = {}
+        for j in range(batch["entity_offsets"][i], batch["entity_offsets"][i + 1]):
+            name = batch["entity_names"][batch["entity_keys"][j]]
+            begin, end = batch["value_offsets"][j], batch["value_offsets"][j + 1]
+            entities[name] = values[begin:end].decode("utf-8")
+        assert entities == dict(expected.entities)
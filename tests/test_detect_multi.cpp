@@ -0,0 +1,80 @@
+// Kiểm thử detect_multi: mỗi mệnh đề cho một span (kể cả "unknown") với vị trí
+// byte trong văn bản gốc, và kết quả từng span khớp detect() trên mệnh đề đó.
+#include "viet_intent.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+struct Span {
+    const char* intent;
+    size_t begin;
+    size_t end;
+};
+
+struct Case {
+    const char* text;
+    std::vector<Span> spans;
+};
+
+const Case CASES[] = {
+    {"chào bạn, cho tôi 2 phở bò, giá bao nhiêu?",
+     {{"greeting", 0, 11}, {"unknown", 13, 33}, {"ask_price", 35, 50}}},
+    {"tôi muốn đặt phở với bún chả", {{"order_food", 0, 24}, {"unknown", 31, 41}}},
+    {"cảm ơn và tạm biệt", {{"thank_you", 0, 9}, {"goodbye", 14, 26}}},
+    {"mấy giờ rồi", {{"ask_time", 0, 17}}},
+};
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+
+    IntentEngine engine;
+    for (const auto& c : CASES) {
+        const std::string text = c.text;
+        auto spans = engine.detect_multi(text);
+        if (spans.size() != c.spans.size()) {
+            std::cerr << "FAIL \"" << text << "\": expected " << c.spans.size() << " spans, got "
+                      << spans.size() << "\n";
+            ++failures;
+            continue;
+        }
+
+        for (size_t i = 0; i < spans.size(); ++i) {
+            const auto& span = spans[i];
+            const auto& expected = c.spans[i];
+            if (span.intent != expected.intent || span.begin != expected.begin ||
+                span.end != expected.end) {
+                std::cerr << "FAIL \"" << text << "\" span " << i << ": expected "
+                          << expected.intent << " [" << expected.begin << "," << expected.end
+                          << "), got " << span.intent << " [" << span.begin << "," << span.end
+                          << ")\n";
+                ++failures;
+                continue;
+            }
+            if (span.text != text.substr(span.begin, span.end - span.begin)) {
+                std::cerr << "FAIL \"" << text << "\" span " << i << ": text \"" << span.text
+                          << "\" does not match its offsets\n";
+                ++failures;
+            }
+
+            IntentResult single = engine.detect(span.text);
+            if (single.intent != span.intent || single.confidence != span.confidence ||
+                single.entities != span.entities) {
+                std::cerr << "FAIL \"" << span.text << "\": detect_multi and detect differ\n";
+                ++failures;
+            }
+        }
+    }
+
+    std::cout.rdbuf(old);
+    if (failures == 0) std::cout << "passed\n";
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// Kiểm thử NumberParser: mỗi dòng là câu đầu vào và các entity mong đợi
+// theo thứ tự xuất hiện, dạng "loại:giá trị" (NumberParser::format).
+#include "number_parser.h"
+#include "text_preprocessor.h"
+#include "viet_intent.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+struct Case {
+    const char* text;
+    const char* expected;   // "" = không có entity nào
+};
+
+const Case CASES[] = {
+    // Chữ số
+    {"cho tôi 2 phở", "number:2"},
+    {"10 ly trà đá", "number:10"},
+    {"1 ly", "number:1"},
+    {"1,5 kg", "number:1.5"},
+    {"3 rưỡi", "number:3.5"},
+    {"1.000,5", "number:1000.5"},
+    {"1,000.5 kg", "number:1000.5"},
+    {"tám ly", "number:8"},
+    {"hai mươi tám", "number:28"},
+
+    // Số đọc bằng chữ
+    {"hai mươi lăm", "number:25"},
+    {"mười", "number:10"},
+    {"mười lăm", "number:15"},
+    {"một trăm linh năm", "number:105"},
+    {"ba trăm", "number:300"},
+    {"ba", "number:3"},
+
+    // Tiền
+    {"50k", "money:50000"},
+    {"2tr5", "money:2500000"},
+    {"30.000đ", "money:30000"},
+    {"1.500.000 đồng", "money:1500000"},
+    {"1.500.000", "money:1500000"},
+    {"giá 1.500.000", "money:1500000"},
+    {"hai mươi lăm nghìn", "money:25000"},
+    {"hai triệu tư", "money:2400000"},
+    {"một triệu rưỡi", "money:1500000"},
+    {"5 nghìn", "money:5000"},
+
+    // Giờ
+    {"7 giờ tối", "time:19:00"},
+    {"7h30", "time:07:30"},
+    {"7:30", "time:07:30"},
+    {"8 giờ kém 15", "time:07:45"},
+    {"bảy giờ rưỡi sáng", "time:07:30"},
+    {"đặt bàn lúc 7 giờ tối cho 4 người", "time:19:00 number:4"},
+
+    // Chuỗi con không phải số
+    {"giá bao nhiêu", ""},
+    {"bây giờ mấy giờ", ""},
+    {"không có gì", ""},
+
+    // Từ trùng chữ với số sau khi bỏ dấu
+    {"tạm biệt", ""},
+    {"sau khi ăn", ""},
+    {"năm nay", ""},
+    {"năm 2024", "number:2024"},
+    {"tạm", ""},
+    {"ăn tạm", ""},
+    {"tấm ảnh", ""},
+    {"chào bà", ""},
+    {"một chút", ""},
+    {"cơm tấm", ""},
+    {"cho 2 cơm tấm", "number:2"},
+    {"phở bò chín", ""},
+    {"phở tái chín", ""},
+    {"chè ba màu", ""},
+    {"thịt ba chỉ", ""},
+    {"cơm hải sản", ""},
+    {"hủ tiếu nam vang", ""},
+    {"vé máy bay", ""},
+};
+
+std::string describe(const std::string& normalized) {
+    NumericEntity found[16];
+    size_t count = NumberParser::parse(normalized, found, 16);
+    std::ostringstream out;
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) out << ' ';
+        switch (found[i].type) {
+            case NumericType::NUMBER: out << "number:"; break;
+            case NumericType::MONEY: out << "money:"; break;
+            case NumericType::TIME: out << "time:"; break;
+        }
+        out << NumberParser::format(found[i]);
+    }
+    return out.str();
+}
+
+// Entity số của detect(): "quantity" không lấy số từ tên món, giá viết có
+// phân cách hàng nghìn là "price"
+struct EntityCase {
+    const char* text;
+    const char* entity;
+    const char* value;      // "" = không có entity
+};
+
+const EntityCase ENTITY_CASES[] = {
+    {"tôi muốn đặt cơm tấm", "quantity", ""},
+    {"tôi muốn đặt 2 cơm tấm", "quantity", "2"},
+    {"tôi muốn đặt 10 phở bò", "quantity", "10"},
+    {"cho tôi ba bánh bao", "quantity", "3"},
+    {"tôi muốn đặt hai phở bò", "quantity", "2"},   // chữ số, không phải "hai"
+    {"giá 1.500.000", "price", "1500000"},
+};
+
+}
+
+int main() {
+    int failures = 0;
+
+    for (const auto& c : CASES) {
+        std::string actual = describe(TextPreprocessor::normalize(c.text));
+        if (actual != c.expected) {
+            std::cerr << "FAIL \"" << c.text << "\": expected \"" << c.expected
+                      << "\", got \"" << actual << "\"\n";
+            ++failures;
+        }
+    }
+
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    IntentEngine full;
+    for (const auto& c : ENTITY_CASES) {
+        auto result = full.detect(c.text);
+        auto it = result.entities.find(c.entity);
+        std::string actual = it == result.entities.end() ? "" : it->second;
+        if (actual != c.value) {
+            std::cerr << "FAIL " << c.entity << " \"" << c.text << "\": expected \"" << c.value
+                      << "\", got \"" << actual << "\"\n";
+            ++failures;
+        }
+    }
+    std::cout.rdbuf(old);
+
+    const size_t total = sizeof(CASES) / sizeof(CASES[0]) +
+                         sizeof(ENTITY_CASES) / sizeof(ENTITY_CASES[0]);
+    std::cout << total - failures << "/" << total << " passed" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
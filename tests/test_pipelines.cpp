@@ -0,0 +1,127 @@
+// Kiểm thử các biến thể pipeline dựng sẵn so với đường chung (FULL qua detect(),
+// có debug): NO_ENTITIES cho cùng intent và độ tin cậy, FAST cho cùng intent khi
+// câu trùng khớp một pattern, và mỗi biến thể cho cùng kết quả qua detect(),
+// detect_batch(), detect_multi() và phiên.
+#include "viet_intent.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+const std::vector<std::string> SENTENCES = {
+    "xin chào",
+    "chào bạn",
+    "tôi muốn đặt 2 phở bò",
+    "cho tôi 3 ly cà phê sữa đá",
+    "giá bánh mì bao nhiêu",
+    "cơm bao nhiêu tiền",
+    "mấy giờ rồi",
+    "bây giờ là mấy giờ",
+    "cảm ơn bạn nhiều",
+    "tạm biệt nhé",
+    "hẹn gặp lại",
+    "tôi muốn đặt bàn cho 4 người",
+    "kiểm tra đơn hàng giúp tôi",
+    "hủy đơn hàng",
+    "hôm nay trời đẹp quá",
+    "",
+    "asdf qwerty",
+};
+
+// Câu trùng khớp đúng một pattern: FAST phải ra cùng intent với FULL
+const std::vector<std::string> EXACT = {
+    "mấy giờ rồi", "giá bao nhiêu", "cảm ơn bạn", "tạm biệt", "kiểm tra đơn hàng",
+    "hủy đơn hàng", "không mua nữa",
+};
+
+const char* pipeline_name(Pipeline pipeline) {
+    switch (pipeline) {
+        case Pipeline::FULL: return "full";
+        case Pipeline::FAST: return "fast";
+        case Pipeline::NO_ENTITIES: return "no-entities";
+    }
+    return "?";
+}
+
+void add_custom_intents(IntentEngine& engine) {
+    engine.add_intent("check_order", {"kiểm tra đơn hàng", "đơn hàng của tôi đâu"});
+    engine.add_intent("cancel_order", {"hủy đơn hàng", "không mua nữa"});
+    engine.add_intent("change_address", {"đổi địa chỉ giao hàng", "giao tới chỗ khác"});
+}
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+    auto fail = [&](Pipeline pipeline, const std::string& text, const std::string& message) {
+        std::cerr << "FAIL " << pipeline_name(pipeline) << " \"" << text << "\": " << message
+                  << "\n";
+        ++failures;
+    };
+
+    IntentEngine full(Pipeline::FULL);
+    add_custom_intents(full);
+
+    for (Pipeline pipeline : {Pipeline::FULL, Pipeline::NO_ENTITIES, Pipeline::FAST}) {
+        IntentEngine engine(pipeline);
+        add_custom_intents(engine);
+        BatchResult batch = engine.detect_batch(SENTENCES);
+
+        for (size_t i = 0; i < SENTENCES.size(); ++i) {
+            const std::string& text = SENTENCES[i];
+            IntentResult got = engine.detect(text);
+            IntentResult reference = full.detect(text);
+
+            if (pipeline == Pipeline::NO_ENTITIES &&
+                (got.intent != reference.intent || got.confidence != reference.confidence)) {
+                fail(pipeline, text, got.intent + " " + std::to_string(got.confidence) +
+                                         ", full " + reference.intent + " " +
+                                         std::to_string(reference.confidence));
+            }
+            if (pipeline != Pipeline::FULL && !got.entities.empty()) {
+                fail(pipeline, text, "entities without an entity stage");
+            }
+
+            // Các đường khác của cùng biến thể (không debug) khớp detect()
+            if (batch.intent_names[batch.intent_ids[i]] != got.intent ||
+                batch.confidences[i] != static_cast<float>(got.confidence)) {
+                fail(pipeline, text, "detect_batch differs from detect");
+            }
+
+            auto session = engine.create_session();
+            session->append(text);
+            const IntentResult& partial = session->current();
+            if (partial.intent != got.intent || partial.confidence != got.confidence) {
+                fail(pipeline, text, "session " + partial.intent + " differs from detect " +
+                                         got.intent);
+            }
+
+            if (!text.empty()) {
+                auto spans = engine.detect_multi(text);
+                if (spans.size() == 1 && spans[0].text == text &&
+                    (spans[0].intent != got.intent || spans[0].confidence != got.confidence)) {
+                    fail(pipeline, text, "detect_multi differs from detect");
+                }
+            }
+        }
+
+        for (const auto& text : EXACT) {
+            IntentResult got = engine.detect(text);
+            IntentResult reference = full.detect(text);
+            if (got.intent != reference.intent) {
+                fail(pipeline, text, "exact match gives " + got.intent + ", full " +
+                                         reference.intent);
+            }
+        }
+    }
+
+    std::cout.rdbuf(old);
+    if (failures == 0) std::cout << "passed\n";
+    return failures == 0 ? 0 : 1;
+}
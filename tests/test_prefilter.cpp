@@ -0,0 +1,125 @@
+// Kiểm thử bộ lọc ngoài miền: câu ngoài miền bị loại cả trên model mặc định
+// lẫn model lớn nạp qua add_intents; câu gọi món, hỏi giá, hỏi giờ thì không.
+#include "viet_intent.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+const char* const OUT_OF_DOMAIN[] = {
+    "zzqx wwpr yyfj",
+    "bóng đá ngoại hạng tối qua",
+    "lập trình python nâng cao",
+    "học tiếng nhật online miễn phí",
+    "sửa máy giặt tại nhà",
+    "đăng ký khóa học yoga",
+};
+
+// Câu trong miền phải qua được bộ lọc (khi bật)
+const char* const IN_DOMAIN[] = {
+    "cho mình hai phần cơm gà xối mỡ",
+    "tôi muốn đặt 2 phở bò",
+    "giá bánh mì bao nhiêu",
+    "mấy giờ rồi",
+    "cho tôi một tô bún bò huế",
+    "cho anh một ly trà sữa trân châu",
+    "cho tôi 1 ly sinh tố bơ",
+};
+
+// Cấu hình mặc định (bộ lọc tắt): kết quả như trước khi có bộ lọc
+struct Expected {
+    const char* text;
+    const char* intent;
+    const char* quantity;
+};
+
+const Expected DEFAULT_CONFIG[] = {
+    {"cho mình hai phần cơm gà xối mỡ", "order_food", "2"},
+    {"cho anh một ly trà sữa trân châu", "order_food", "1"},
+};
+
+// Danh mục lớn: 5000 intent x 20 pattern, từ vựng không giao với các câu trên
+std::vector<IntentSpec> large_catalog() {
+    const char* const words[] = {"kho", "lo", "sp", "ma", "dv", "goi", "the", "vi", "kenh", "tram"};
+    std::vector<IntentSpec> specs;
+    for (int i = 0; i < 5000; ++i) {
+        IntentSpec spec;
+        spec.name = "catalog_" + std::to_string(i);
+        for (int j = 0; j < 20; ++j) {
+            spec.patterns.push_back(std::string(words[(i + j) % 10]) + "x" + std::to_string(i) +
+                                    " " + words[(i * 7 + j) % 10] + "y" + std::to_string(j));
+        }
+        specs.push_back(std::move(spec));
+    }
+    return specs;
+}
+
+int check(IntentEngine& engine, const char* label, bool in_domain) {
+    PrefilterConfig config;
+    config.enabled = true;
+    engine.set_prefilter(config);
+
+    int failures = 0;
+    for (const char* text : OUT_OF_DOMAIN) {
+        auto result = engine.detect(text);
+        if (result.intent != "unknown" || result.stages != STAGE_PREFILTER) {
+            std::cerr << "FAIL " << label << " \"" << text << "\": not rejected ("
+                      << result.intent << ")\n";
+            ++failures;
+        }
+    }
+    if (!in_domain) return failures;
+
+    for (const char* text : IN_DOMAIN) {
+        auto result = engine.detect(text);
+        if (result.stages == STAGE_PREFILTER) {
+            std::cerr << "FAIL " << label << " \"" << text << "\": rejected\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+int check_default_config() {
+    IntentEngine engine;
+    int failures = 0;
+    if (engine.prefilter().enabled) {
+        std::cerr << "FAIL prefilter is enabled by default\n";
+        ++failures;
+    }
+    for (const auto& c : DEFAULT_CONFIG) {
+        auto result = engine.detect(c.text);
+        auto it = result.entities.find("quantity");
+        std::string quantity = it == result.entities.end() ? "" : it->second;
+        if (result.intent != c.intent || quantity != c.quantity) {
+            std::cerr << "FAIL default config \"" << c.text << "\": got " << result.intent
+                      << " quantity=" << quantity << "\n";
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+
+    int failures = check_default_config();
+
+    IntentEngine engine(Pipeline::NO_ENTITIES);
+    failures += check(engine, "default model", true);
+
+    IntentEngine large(Pipeline::NO_ENTITIES);
+    large.add_intents(large_catalog());
+    failures += check(large, "large model", false);
+
+    std::cout.rdbuf(old);
+    std::cout << (failures == 0 ? "passed" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
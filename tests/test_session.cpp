@@ -0,0 +1,73 @@
+// Kiểm thử phiên tăng dần: kết quả khớp detect(), và chi phí một lần nối thêm
+// không tăng theo độ dài văn bản đã có trong phiên.
+#include "viet_intent.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace VietIntent;
+
+namespace {
+
+// Trung vị thời gian (µs) của một lần append(chunk) khi phiên đã có khoảng length byte
+double append_median_us(IntentEngine& engine, size_t length, const std::string& chunk) {
+    auto session = engine.create_session();
+    while (session->text().size() < length) session->append(chunk);
+
+    std::vector<double> samples;
+    for (int i = 0; i < 301; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        session->append(chunk);
+        samples.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+}
+
+int main() {
+    std::ostringstream sink;
+    auto* old = std::cout.rdbuf(sink.rdbuf());
+    int failures = 0;
+
+    IntentEngine engine(Pipeline::NO_ENTITIES);
+
+    // Nối từng từ cho cùng kết quả với detect() trên cả câu
+    const std::vector<std::string> sentences = {
+        "xin chào", "cho tôi 2 tô phở bò", "giá bánh mì bao nhiêu", "mấy giờ rồi",
+        "cảm ơn bạn nhiều", "tạm biệt nhé", "tôi muốn đặt bàn cho 4 người",
+    };
+    for (const auto& text : sentences) {
+        auto session = engine.create_session();
+        std::istringstream words(text);
+        std::string word;
+        while (words >> word) session->append(word + " ");
+        IntentResult expected = engine.detect(text);
+        const IntentResult& got = session->current();
+        if (got.intent != expected.intent || got.confidence != expected.confidence) {
+            std::cerr << "FAIL \"" << text << "\": session " << got.intent << " "
+                      << got.confidence << ", detect " << expected.intent << " "
+                      << expected.confidence << "\n";
+            ++failures;
+        }
+    }
+
+    // Nối thêm vào phiên 100 KB không chậm hơn nhiều so với phiên 1 KB
+    const std::string chunk = "cho toi mot bat pho ";
+    double short_us = append_median_us(engine, 1000, chunk);
+    double long_us = append_median_us(engine, 100000, chunk);
+    if (long_us > 4.0 * short_us + 5.0) {
+        std::cerr << "FAIL append cost grows with session length: " << short_us
+                  << " us at 1 KB, " << long_us << " us at 100 KB\n";
+        ++failures;
+    }
+
+    std::cout.rdbuf(old);
+    if (failures == 0) std::cout << "passed\n";
+    return failures == 0 ? 0 : 1;
+}